@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct Benchmark
+{
+    const char *name;
+    void (*run)(const std::string &corpus);
+};
+
+inline std::vector<Benchmark> &GetBenchmarks()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+// benchmarks that make their own input leave corpus unused
+#define BENCHMARK(group, name)                                                                                     \
+    static void group##_##name([[maybe_unused]] const std::string &corpus);                                        \
+    static bool group##_##name##_registered = (GetBenchmarks().push_back({#group "." #name, group##_##name}), true); \
+    static void group##_##name([[maybe_unused]] const std::string &corpus)
+
+// number of calls to operator new so far
+size_t GetAllocationCount();
+
+// runs the function a few times and returns the fastest run in seconds
+template <typename Function>
+inline double Measure(Function fn, size_t iterations = 5)
+{
+    double best = 0;
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (i == 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+inline void Report(const char *name, size_t bytes, double seconds, const std::string &extra = "")
+{
+    printf("%-40s %10.2f MB/s %10.3f ms %s\n", name, bytes / seconds / (1024 * 1024), seconds * 1000, extra.c_str());
+}
+
+// synthetic lua code with a mix of identifiers, numbers, strings, comments and nested tables
+inline std::string GenerateCorpus(size_t target_size)
+{
+    const char *chunk =
+        "-- generated data table\n"
+        "local data_table = {\n"
+        "    name = \"some string value\", id = 0x1F2E, ratio = 1.5e+10,\n"
+        "    [\"key with spaces\"] = { 1, 2, 3, 4, 5, 6, 7, 8 },\n"
+        "    nested = { a = { b = { c = 'deep' } } },\n"
+        "}\n"
+        "--[[ a long comment\n    spanning lines ]]\n"
+        "local function update(self, dt)\n"
+        "    self.position = self.position + self.velocity * dt\n"
+        "    return self:render(\"frame\", [[long string]]) .. tostring(dt)\n"
+        "end\n";
+
+    std::string code;
+    code.reserve(target_size);
+
+    while (code.size() < target_size)
+        code += chunk;
+
+    return code;
+}
@@ -0,0 +1,145 @@
+#include "./Helpers.hpp"
+#include "../src/lexer/LuaLexer.hpp"
+#include <algorithm>
+#include <thread>
+
+static size_t GetTokenMemoryUsage(const std::vector<std::unique_ptr<Token>> &tokens)
+{
+    auto bytes = tokens.capacity() * sizeof(std::unique_ptr<Token>);
+
+    for (auto &token : tokens)
+    {
+        bytes += sizeof(Token);
+        bytes += token->whitespace.capacity() * (sizeof(std::unique_ptr<Token>) + sizeof(Token));
+    }
+
+    return bytes;
+}
+
+BENCHMARK(Lexer, GetTokens)
+{
+    auto code = std::make_shared<Code>(corpus, "corpus");
+    size_t count = 0;
+    size_t bytes = 0;
+
+    auto seconds = Measure([&]()
+                           {
+                               auto lexer = LuaLexer(code);
+                               auto [tokens, errors] = lexer.GetTokens();
+                               count = tokens.size();
+                               bytes = GetTokenMemoryUsage(tokens); });
+
+    Report("Lexer.GetTokens", corpus.size(), seconds, std::to_string(bytes / count) + " bytes/token");
+}
+
+BENCHMARK(Lexer, GetTokensWithoutWhitespace)
+{
+    auto code = std::make_shared<Code>(corpus, "corpus");
+    size_t count = 0;
+    size_t bytes = 0;
+
+    auto seconds = Measure([&]()
+                           {
+                               auto lexer = LuaLexer(code);
+                               lexer.keep_whitespace = false;
+                               auto [tokens, errors] = lexer.GetTokens();
+                               count = tokens.size();
+                               bytes = GetTokenMemoryUsage(tokens); });
+
+    Report("Lexer.GetTokensWithoutWhitespace", corpus.size(), seconds, std::to_string(bytes / count) + " bytes/token");
+}
+
+BENCHMARK(Lexer, GetTokenBuffer)
+{
+    auto code = std::make_shared<Code>(corpus, "corpus");
+    size_t count = 0;
+    size_t bytes = 0;
+
+    auto seconds = Measure([&]()
+                           {
+                               auto lexer = LuaLexer(code);
+                               auto buffer = lexer.GetTokenBuffer();
+                               count = buffer.Size();
+                               bytes = buffer.GetMemoryUsage(); });
+
+    Report("Lexer.GetTokenBuffer", corpus.size(), seconds, std::to_string(bytes / count) + " bytes/token");
+}
+
+BENCHMARK(Lexer, GetTokenBufferInParallel)
+{
+    auto code = std::make_shared<Code>(corpus, "corpus");
+    auto thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+    auto seconds = Measure([&]()
+                           {
+                               auto lexer = LuaLexer(code);
+                               auto buffer = lexer.GetTokenBufferInParallel(thread_count); });
+
+    Report("Lexer.GetTokenBufferInParallel", corpus.size(), seconds, std::to_string(thread_count) + " threads");
+}
+
+BENCHMARK(Lexer, GetTokenBufferWithErrors)
+{
+    // break the numbers and strings so most lines produce an error
+    auto broken = corpus;
+    auto replace_all = [&](std::string_view from, std::string_view to)
+    {
+        for (auto pos = broken.find(from); pos != std::string::npos; pos = broken.find(from, pos + to.size()))
+            broken.replace(pos, from.size(), to);
+    };
+    replace_all("0x1F2E", "0x1FZE");
+    replace_all("1.5e+10", "1.5e+D0");
+    replace_all("\"frame\"", "\"frame\n");
+
+    auto code = std::make_shared<Code>(broken, "corpus");
+    size_t errors = 0;
+
+    auto seconds = Measure([&]()
+                           {
+                               auto lexer = LuaLexer(code);
+                               auto buffer = lexer.GetTokenBuffer();
+                               errors = buffer.diagnostics.size(); });
+
+    Report("Lexer.GetTokenBufferWithErrors", broken.size(), seconds, std::to_string(errors) + " errors");
+}
+
+BENCHMARK(Lexer, Relex)
+{
+    // type one character in the middle of the corpus and delete it again
+    auto original = std::make_shared<Code>(corpus, "corpus");
+    auto edited = corpus;
+    auto start = edited.find("self.position", edited.size() / 2) + 4;
+    edited.insert(start, "x");
+    auto code = std::make_shared<Code>(edited, "corpus");
+
+    auto buffer = LuaLexer(original).GetTokenBuffer();
+    size_t relexed = 0;
+
+    auto seconds = Measure([&]()
+                           {
+                               auto lexer = LuaLexer(code);
+                               buffer = lexer.Relex(std::move(buffer), {.start = start, .removed = 0, .inserted = 1});
+                               relexed = lexer.position - start;
+
+                               auto undo = LuaLexer(original);
+                               buffer = undo.Relex(std::move(buffer), {.start = start, .removed = 1, .inserted = 0}); });
+
+    Report("Lexer.Relex", edited.size(), seconds / 2, "stopped " + std::to_string(relexed) + " bytes after the edit");
+}
+
+BENCHMARK(Lexer, SmallFiles)
+{
+    // many short files, where setting up the lexer costs as much as lexing
+    auto code = std::make_shared<Code>(corpus.substr(0, 100), "small");
+    const size_t count = 10000;
+
+    auto seconds = Measure([&]()
+                           {
+                               for (size_t i = 0; i < count; i++)
+                               {
+                                   auto lexer = LuaLexer(code);
+                                   auto buffer = lexer.GetTokenBuffer();
+                               } });
+
+    Report("Lexer.SmallFiles", 100 * count, seconds, std::to_string(seconds / count * 1e6) + " us/file");
+}
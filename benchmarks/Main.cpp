@@ -0,0 +1,68 @@
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include "./Helpers.hpp"
+#include "../src/lexer/ScanKernels.hpp"
+
+static std::atomic<size_t> allocation_count = 0;
+
+size_t GetAllocationCount()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+// counts every allocation so benchmarks can report allocations per file
+void *operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto memory = std::malloc(size ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+// usage: benchmarks [filter] [file.lua...]
+// without files a synthetic corpus is used
+int main(int argc, char **argv)
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+    std::string corpus;
+
+    for (int i = 2; i < argc; i++)
+    {
+        std::ifstream file(argv[i], std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        corpus += ss.str();
+        corpus += "\n";
+    }
+
+    if (corpus.empty())
+        corpus = GenerateCorpus(8 * 1024 * 1024);
+
+    printf("corpus: %zu bytes\n", corpus.size());
+    printf("scan kernels: %s\n", ScanKernels::GetImplementationName());
+
+    for (auto &benchmark : GetBenchmarks())
+    {
+        if (std::string(benchmark.name).find(filter) == std::string::npos)
+            continue;
+
+        benchmark.run(corpus);
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include "./Helpers.hpp"
+#include "../src/lexer/LuaLexer.hpp"
+#include "../src/parser/Statement.hpp"
+
+// one large table constructor
+static std::string GenerateExpression(size_t target_size)
+{
+    const char *entry = "{name = \"value\", [1 + 2 * 3] = foo.bar:baz(1, 2), list = {1, 2, 3, 4}, -x ^ 2 .. 'a', function() end},\n";
+
+    std::string code = "{\n";
+
+    while (code.size() < target_size)
+        code += entry;
+
+    code += "}";
+
+    return code;
+}
+
+BENCHMARK(Parser, ParseExpression)
+{
+    auto expression = GenerateExpression(corpus.size() / 4);
+    auto code = std::make_shared<Code>(expression, "expression");
+    auto buffer = LuaLexer(code).GetTokenBuffer();
+    size_t arena_size = 0;
+    size_t node_count = 0;
+    double teardown = 0;
+
+    auto seconds = Measure([&]()
+                           {
+                               auto parser = std::make_shared<LuaParser>(buffer);
+                               auto result = parser->ParseExpression();
+                               arena_size = result.GetStorage()->arena.GetSize();
+                               node_count = result.GetStorage()->node_count;
+
+                               auto start = std::chrono::steady_clock::now();
+                               parser = nullptr;
+                               result = {};
+                               teardown = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); });
+
+    Report("Parser.ParseExpression", code->GetByteSize(), seconds, std::to_string(arena_size / 1024) + " KB of nodes, " + std::to_string(arena_size / node_count) + " bytes/node, " + std::to_string(teardown * 1000) + " ms teardown");
+}
+
+BENCHMARK(Parser, ParseOperators)
+{
+    // one long chain of binary operators, every operand goes through the postfix and operator checks
+    std::string expression = "a";
+
+    while (expression.size() < corpus.size() / 4)
+        expression += " + b * c - d / e ^ f + i.j:k(1) - l[2] % 'g'";
+
+    auto code = std::make_shared<Code>(expression, "operators");
+    auto buffer = LuaLexer(code).GetTokenBuffer();
+    size_t node_count = 0;
+    double parsing = 0;
+
+    Measure([&]()
+            {
+                // the tokens are copied into the parser's store up front, only the descent is timed
+                auto parser = LuaParser(buffer);
+                auto start = std::chrono::steady_clock::now();
+                auto result = parser.ParseExpression();
+                auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                if (parsing == 0 || seconds < parsing)
+                    parsing = seconds;
+
+                node_count = result.GetStorage()->node_count; });
+
+    Report("Parser.ParseOperators", code->GetByteSize(), parsing, std::to_string(node_count) + " nodes");
+}
+
+BENCHMARK(Parser, SmallFiles)
+{
+    // a batch run over many short files, once with a new lexer and parser per file and once reusing them
+    const char *source = "{name = \"value\", [1 + 2 * 3] = foo.bar:baz(1, 2), list = {1, 2, 3, 4}, -x ^ 2 .. 'a'}";
+    const size_t count = 100000;
+    size_t allocations = 0;
+
+    auto fresh = Measure([&]()
+                         {
+                             auto before = GetAllocationCount();
+
+                             for (size_t i = 0; i < count; i++)
+                             {
+                                 auto code = std::make_shared<Code>(source, "small");
+                                 auto lexer = LuaLexer(code);
+                                 lexer.keep_whitespace = false;
+                                 auto parser = std::make_shared<LuaParser>(lexer.GetTokenBuffer());
+                                 auto result = parser->ParseExpression();
+                             }
+
+                             allocations = GetAllocationCount() - before; },
+                         3);
+
+    Report("Parser.SmallFiles", strlen(source) * count, fresh, std::to_string(fresh / count * 1e6) + " us/file, " + std::to_string(allocations / count) + " allocations/file");
+
+    auto lexer = LuaLexer(std::make_shared<Code>(source, "small"));
+    lexer.keep_whitespace = false;
+    auto buffer = TokenBuffer(lexer.code);
+    auto parser = LuaParser();
+
+    auto reused = Measure([&]()
+                          {
+                              auto before = GetAllocationCount();
+
+                              for (size_t i = 0; i < count; i++)
+                              {
+                                  lexer.Reset(std::make_shared<Code>(source, "small"));
+                                  lexer.GetTokenBuffer(buffer);
+                                  parser.Reset(buffer);
+                                  auto result = parser.ParseExpression();
+                              }
+
+                              allocations = GetAllocationCount() - before; },
+                          3);
+
+    Report("Parser.SmallFilesReused", strlen(source) * count, reused, std::to_string(reused / count * 1e6) + " us/file, " + std::to_string(static_cast<double>(allocations) / count) + " allocations/file");
+}
+
+BENCHMARK(Parser, ParseFile)
+{
+    // the whole corpus as one file, once into a single tree and once a top level statement at a time
+    auto code = std::make_shared<Code>(corpus, "corpus");
+    auto lexer = LuaLexer(code);
+    lexer.keep_whitespace = false;
+    auto buffer = lexer.GetTokenBuffer();
+    size_t arena_size = 0;
+    size_t statement_count = 0;
+
+    auto whole = Measure([&]()
+                         {
+                             auto parser = LuaParser(buffer);
+                             auto result = parser.ParseFile();
+                             arena_size = result.GetStorage()->arena.GetSize();
+                             statement_count = result->statements.size(); },
+                         3);
+
+    Report("Parser.ParseFile", code->GetByteSize(), whole, std::to_string(statement_count) + " statements, " + std::to_string(arena_size / 1024) + " KB of nodes");
+
+    size_t largest_arena = 0;
+
+    auto streamed = Measure([&]()
+                            {
+                                auto parser = LuaParser(buffer);
+                                parser.ParseStatements([&](ParseResult<Statement> statement)
+                                                       { largest_arena = std::max(largest_arena, statement.GetStorage()->arena.GetCapacity()); }); },
+                            3);
+
+    Report("Parser.ParseStatements", code->GetByteSize(), streamed, std::to_string(largest_arena / 1024) + " KB of nodes at most");
+}
+
+BENCHMARK(Parser, ParseBrokenFile)
+{
+    // the corpus with a bracket, comma or the d of end dropped from the end of every seventh line that has one,
+    // to compare with Parser.ParseFile
+    std::string broken;
+    broken.reserve(corpus.size());
+    size_t line = 0;
+
+    for (size_t start = 0; start < corpus.size();)
+    {
+        auto end = corpus.find('\n', start);
+        end = end == std::string::npos ? corpus.size() : end + 1;
+        auto length = end - start;
+
+        if (line++ % 7 == 0 && length > 2 && corpus[end - 1] == '\n' && strchr(",{})d", corpus[end - 2]))
+            broken.append(corpus, start, length - 2).push_back('\n');
+        else
+            broken.append(corpus, start, length);
+
+        start = end;
+    }
+
+    auto code = std::make_shared<Code>(broken, "broken");
+    auto lexer = LuaLexer(code);
+    lexer.keep_whitespace = false;
+    auto buffer = lexer.GetTokenBuffer();
+    size_t diagnostic_count = 0;
+
+    auto seconds = Measure([&]()
+                           {
+                               auto parser = LuaParser(buffer);
+                               auto result = parser.ParseFile();
+                               diagnostic_count = result.GetDiagnostics().size(); },
+                           3);
+
+    Report("Parser.ParseBrokenFile", code->GetByteSize(), seconds, std::to_string(diagnostic_count) + " diagnostics");
+}
@@ -1,15 +1,34 @@
 #include "../parser/LuaParser.hpp"
 #include "../parser/PrimaryExpression.hpp"
+#include "../lexer/StringLiteral.hpp"
 #include <string>
 
 class BaseType
 {
-    virtual void lol(){};
+public:
+    enum class Kind : uint8_t
+    {
+        Symbol,
+        Number,
+        String,
+    };
+
+    Kind kind;
+
+    static constexpr bool IsKind(Kind) { return true; }
+
+protected:
+    explicit BaseType(Kind kind)
+    {
+        this->kind = kind;
+    }
 };
 
 class Symbol : public BaseType
 {
 public:
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::Symbol; }
+
     enum LuaType
     {
         Nil,
@@ -19,7 +38,7 @@ public:
 
     size_t value;
 
-    Symbol(size_t value)
+    Symbol(size_t value) : BaseType(Kind::Symbol)
     {
         this->value = value;
     }
@@ -28,9 +47,11 @@ public:
 class Number : public BaseType
 {
 public:
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::Number; }
+
     double value;
 
-    Number(double value)
+    Number(double value) : BaseType(Kind::Number)
     {
         this->value = value;
     }
@@ -39,119 +60,84 @@ public:
 class String : public BaseType
 {
 public:
-    std::string value;
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::String; }
+
+    // points into the code or the analyzer's string cache
+    std::string_view value;
 
-    String(std::string value)
+    String(std::string_view value) : BaseType(Kind::String)
     {
         this->value = value;
     }
 };
 
-std::shared_ptr<Number> LNumberFromString(std::string str)
+std::shared_ptr<Number> LNumberFromToken(const Token &token)
 {
-    std::string lower;
-    lower.resize(str.size());
+    // the lexer has usually decoded it already
+    auto value = token.number ? *token.number : NumberLiteral::Decode(token.value);
 
-    std::transform(str.begin(), str.end(), lower.begin(), ::tolower);
-
-    auto num = 0.0;
-
-    if (lower.substr(0, 2) == "0b")
-    {
-        num = std::stoi(lower.substr(2), nullptr, 2);
-    }
-    else if (lower.substr(0, 2) == "0x")
-    {
-        num = std::stoi(lower.substr(2), nullptr, 16);
-    }
-    else if (lower.substr(lower.length() - 2) == "ull")
-    {
-        num = std::stoi(lower.substr(0, lower.length() - 3), nullptr, 10);
-    }
-    else if (lower.substr(lower.length() - 2) == "ll")
-    {
-        num = std::stoi(lower.substr(0, lower.length() - 2), nullptr, 10);
-    }
-    else if (str == "nan")
-    {
-        num = std::numeric_limits<double>::quiet_NaN();
-    }
-    else if (str == "inf")
-    {
-        num = std::numeric_limits<double>::infinity();
-    }
-    else if (str == "-inf")
-    {
-        num = -std::numeric_limits<double>::infinity();
-    }
-    else
-    {
-        num = std::stod(str);
-    }
-
-    return std::make_shared<Number>(num);
+    return std::make_shared<Number>(value.ToDouble());
 }
 
-std::shared_ptr<String> LStringFromString(std::string str)
+std::shared_ptr<String> LStringFromToken(StringLiteralCache &strings, const Token &token)
 {
-    if (str.substr(0, 1) == "[")
-    {
-        auto start = str.find("[=*[", 0);
-        if (start != std::string::npos)
-        {
-            return std::make_shared<String>(str.substr(start + 4, str.length() - start - 5));
-        }
-        else
-        {
-            return std::make_shared<String>("");
-        }
-    }
-    else
-    {
-        return std::make_shared<String>(str.substr(1, str.length() - 2));
-    }
-
-    throw std::runtime_error("cannot convert string: " + str);
+    return std::make_shared<String>(strings.Get(token.index, token.value));
 }
 
 class LuaAnalyzer
 {
 public:
-    std::shared_ptr<BaseType> AnalyzeExpression(std::shared_ptr<Expression> node, ParserNode::Environment env);
+    // the tokens of the parse the analyzed nodes come from
+    std::shared_ptr<const TokenStore> tokens;
+    StringLiteralCache strings;
+
+    explicit LuaAnalyzer(std::shared_ptr<const TokenStore> tokens)
+    {
+        this->tokens = std::move(tokens);
+    }
+
+    std::shared_ptr<BaseType> AnalyzeExpression(Expression *node, ParserNode::Environment env);
 };
 
-std::shared_ptr<BaseType> LuaAnalyzer::AnalyzeExpression(std::shared_ptr<Expression> node, ParserNode::Environment env)
+std::shared_ptr<BaseType> LuaAnalyzer::AnalyzeExpression(Expression *node, ParserNode::Environment env)
 {
-    if (auto value = dynamic_cast<ValueExpression *>(node.get()))
+    switch (node->kind)
+    {
+    case ParserNode::Kind::Atomic:
     {
-        if (auto atomic = dynamic_cast<Atomic *>(value))
+        auto atomic = static_cast<Atomic *>(node);
+        auto typ = atomic->token_type;
+        auto &token = (*tokens)[atomic->value];
+
+        if (typ == LuaParser::TokenType::Keyword)
         {
-            auto typ = atomic->token_type;
-            if (typ == LuaParser::TokenType::Keyword)
+            if (token.atom == Atom::Nil)
             {
-                if (atomic->value->value == "nil")
-                {
-                    return std::make_shared<Symbol>(Symbol::LuaType::Nil);
-                }
-                else if (atomic->value->value == "true")
-                {
-                    return std::make_shared<Symbol>(Symbol::LuaType::True);
-                }
-                else if (atomic->value->value == "false")
-                {
-                    return std::make_shared<Symbol>(Symbol::LuaType::False);
-                }
+                return std::make_shared<Symbol>(Symbol::LuaType::Nil);
             }
-
-            if (typ == LuaParser::TokenType::Number)
+            else if (token.atom == Atom::True)
             {
-                return LNumberFromString(std::string(atomic->value->value));
+                return std::make_shared<Symbol>(Symbol::LuaType::True);
             }
-            else if (typ == LuaParser::TokenType::String)
+            else if (token.atom == Atom::False)
             {
-                return LStringFromString(std::string(atomic->value->value));
+                return std::make_shared<Symbol>(Symbol::LuaType::False);
             }
         }
+
+        if (typ == LuaParser::TokenType::Number)
+        {
+            return LNumberFromToken(token);
+        }
+        else if (typ == LuaParser::TokenType::String)
+        {
+            return LStringFromToken(strings, token);
+        }
+
+        break;
+    }
+    default:
+        break;
     }
 
     return nullptr;
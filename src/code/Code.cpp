@@ -20,7 +20,7 @@ std::string_view Code::GetStringSlice(size_t start, size_t end)
 
 std::optional<size_t> Code::FindNearest(std::string_view pattern, size_t from)
 {
-    auto pos = buffer.find_first_of(pattern, from);
+    auto pos = buffer.find(pattern, from);
 
     if (pos == std::string::npos)
         return std::nullopt;
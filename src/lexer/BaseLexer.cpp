@@ -1,5 +1,6 @@
 #include "./BaseLexer.hpp"
 #include "../code/Code.hpp"
+#include <thread>
 
 std::string_view BaseLexer::GetRelativeStringSlice(size_t start, size_t stop)
 {
@@ -22,6 +23,32 @@ void BaseLexer::ResetState()
 {
     comment_escape = false;
     position = 0;
+    diagnostics.clear();
+}
+
+void BaseLexer::Reset(std::shared_ptr<Code> code)
+{
+    this->code = std::move(code);
+    ResetState();
+}
+
+Atom::Id BaseLexer::GetAtom(Token::Kind kind, std::string_view value)
+{
+    if (kind != Token::Kind::Letter && kind != Token::Kind::Symbol)
+        return Atom::None;
+
+    return atom_cache.Intern(value);
+}
+
+Token::Kind BaseLexer::Error(LexerDiagnostic::Code code, size_t start, size_t stop)
+{
+    diagnostics.push_back(LexerDiagnostic{
+        .code = code,
+        .start = static_cast<uint32_t>(start),
+        .stop = static_cast<uint32_t>(stop),
+    });
+
+    return Token::Kind::Error;
 }
 
 std::optional<size_t> BaseLexer::FindNearest(std::string_view pattern)
@@ -41,55 +68,56 @@ bool BaseLexer::TheEnd()
     return position >= code->GetByteSize();
 }
 
-bool BaseLexer::ReadFirstFromStringArray(std::vector<std::string> strings)
+size_t BaseLexer::MatchLongest(const SymbolMatcher &matcher)
 {
-    for (auto &str : strings)
-    {
-        if (IsString(str))
-        {
-            position += str.size();
-            return true;
-        }
-    }
+    if (TheEnd())
+        return 0;
 
-    return false;
+    return matcher.Match(code->GetStringSlice(position, code->GetByteSize()));
 }
 
-std::unique_ptr<Token> BaseLexer::ReadCommentEscape()
+bool BaseLexer::ReadLongestMatch(const SymbolMatcher &matcher)
+{
+    auto length = MatchLongest(matcher);
+    position += length;
+    return length != 0;
+}
+
+std::optional<Token::Kind> BaseLexer::ReadCommentEscape()
 {
     if (!IsString("--[[#"))
-        return nullptr;
+        return std::nullopt;
 
     position += 5;
     comment_escape = true;
 
-    return std::make_unique<Token>(Token::Kind::CommentEscape);
+    return Token::Kind::CommentEscape;
 }
 
-std::unique_ptr<Token> BaseLexer::ReadRemainingCommentEscape()
+std::optional<Token::Kind> BaseLexer::ReadRemainingCommentEscape()
 {
-    if (!comment_escape || IsString("]]"))
-        return nullptr;
+    if (!comment_escape || !IsString("]]"))
+        return std::nullopt;
 
     position += 2;
     comment_escape = false;
 
-    return std::make_unique<Token>(Token::Kind::CommentEscape);
+    return Token::Kind::CommentEscape;
 }
 
-std::unique_ptr<Token> BaseLexer::ReadEndOfFile()
+std::optional<Token::Kind> BaseLexer::ReadEndOfFile()
 {
     if (!TheEnd())
-        return nullptr;
+        return std::nullopt;
 
-    return std::make_unique<Token>(Token::Kind::EndOfFile);
+    return Token::Kind::EndOfFile;
 }
 
-std::unique_ptr<Token> BaseLexer::ReadUnknown()
+Token::Kind BaseLexer::ReadUnknown()
 {
     position += 1;
 
-    return std::make_unique<Token>(Token::Kind::Unknown);
+    return Token::Kind::Unknown;
 }
 
 /*
@@ -110,10 +138,10 @@ std::unique_ptr<Token> BaseLexer::ReadUnknown()
     }
 */
 
-std::unique_ptr<Token> BaseLexer::ReadShebang()
+std::optional<Token::Kind> BaseLexer::ReadShebang()
 {
     if (position != 0 || !IsString("#", 0))
-        return nullptr;
+        return std::nullopt;
 
     while (!TheEnd())
     {
@@ -123,30 +151,24 @@ std::unique_ptr<Token> BaseLexer::ReadShebang()
             break;
     }
 
-    return std::make_unique<Token>(Token::Kind::Shebang);
+    return Token::Kind::Shebang;
 }
 
-std::unique_ptr<Token> BaseLexer::ReadSingleToken()
+Token::Kind BaseLexer::ReadTokenKind()
 {
-    auto start = position;
+    if (auto kind = ReadShebang())
+        return *kind;
 
-    std::unique_ptr<Token> token;
+    if (auto kind = ReadEndOfFile())
+        return *kind;
 
-    if (auto res = ReadShebang())
-        token = std::move(res);
-    else if (auto res = ReadEndOfFile())
-        token = std::move(res);
-    else if (auto res = ReadWhitespaceToken())
-        token = std::move(res);
-    else if (auto res = ReadNonWhitespaceToken())
-        token = std::move(res);
-    else
-        token = ReadUnknown();
+    if (auto kind = ReadWhitespaceToken())
+        return *kind;
 
-    token->start = start;
-    token->stop = position;
+    if (auto kind = ReadNonWhitespaceToken())
+        return *kind;
 
-    return token;
+    return ReadUnknown();
 }
 
 std::unique_ptr<Token> BaseLexer::ReadToken()
@@ -155,55 +177,388 @@ std::unique_ptr<Token> BaseLexer::ReadToken()
 
     while (true)
     {
-        auto token = ReadSingleToken();
+        auto start = position;
+        auto kind = ReadTokenKind();
 
-        if (token->IsWhitespace())
+        if (Token::IsWhitespace(kind))
         {
-            whitespace_tokens.push_back(std::move(token));
+            if (keep_whitespace)
+            {
+                auto whitespace_token = std::make_unique<Token>(kind);
+                whitespace_token->start = start;
+                whitespace_token->stop = position;
+                whitespace_token->value = code->GetStringSlice(start, position);
+                whitespace_tokens.push_back(std::move(whitespace_token));
+            }
+
+            continue;
         }
-        else
+
+        auto token = std::make_unique<Token>(kind);
+        token->start = start;
+        token->stop = position;
+        token->value = code->GetStringSlice(start, position);
+        token->atom = GetAtom(kind, token->value);
+
+        if (kind == Token::Kind::Number && decode_numbers)
+            token->number = number;
+
+        token->whitespace = std::move(whitespace_tokens);
+
+        return token;
+    }
+}
+
+BaseLexer::TokenIterator::TokenIterator(BaseLexer *lexer)
+{
+    this->lexer = lexer;
+    current = lexer->ReadToken();
+    current->index = index;
+    at_end_of_file = current->kind == Token::Kind::EndOfFile;
+}
+
+BaseLexer::TokenIterator &BaseLexer::TokenIterator::operator++()
+{
+    if (at_end_of_file)
+    {
+        current = nullptr;
+        finished = true;
+    }
+    else
+    {
+        current = lexer->ReadToken();
+        current->index = ++index;
+        at_end_of_file = current->kind == Token::Kind::EndOfFile;
+    }
+
+    return *this;
+}
+
+BaseLexer::TokenIterator BaseLexer::begin()
+{
+    ResetState();
+
+    return TokenIterator(this);
+}
+
+std::vector<BaseLexer::Exception> BaseLexer::GetErrors()
+{
+    auto errors = std::vector<BaseLexer::Exception>();
+
+    for (auto &diagnostic : diagnostics)
+    {
+        errors.push_back(BaseLexer::Exception(diagnostic.GetMessage(code->GetBuffer()), diagnostic.start, diagnostic.stop));
+    }
+
+    return errors;
+}
+
+std::pair<std::vector<std::unique_ptr<Token>>, std::vector<BaseLexer::Exception>> BaseLexer::GetTokens()
+{
+    auto tokens = std::vector<std::unique_ptr<Token>>();
+
+    for (auto &token : *this)
+    {
+        tokens.push_back(std::move(token));
+    }
+
+    return make_pair(std::move(tokens), GetErrors());
+}
+
+TokenBuffer::State BaseLexer::GetState()
+{
+    return comment_escape ? TokenBuffer::State::InCommentEscape : TokenBuffer::State::Normal;
+}
+
+bool BaseLexer::ReadBufferToken(TokenBuffer &buffer)
+{
+    auto state = GetState();
+
+    while (true)
+    {
+        auto start = position;
+        auto kind = ReadTokenKind();
+
+        if (Token::IsWhitespace(kind))
         {
-            for (auto &whitespace_token : whitespace_tokens)
+            if (keep_whitespace)
+                buffer.AddWhitespace(kind, start, position);
+
+            continue;
+        }
+
+        buffer.Add(kind, start, position, state, GetAtom(kind, code->GetStringSlice(start, position)));
+
+        if (kind == Token::Kind::Number && decode_numbers)
+            buffer.AddNumber(number);
+
+        return kind != Token::Kind::EndOfFile;
+    }
+}
+
+TokenBuffer BaseLexer::GetTokenBuffer()
+{
+    auto buffer = TokenBuffer(code);
+    GetTokenBuffer(buffer);
+
+    return buffer;
+}
+
+void BaseLexer::GetTokenBuffer(TokenBuffer &buffer)
+{
+    if (code->GetByteSize() > TokenBuffer::MAX_CODE_SIZE)
+        throw BaseLexer::Exception("code is too large for a token buffer", 0, code->GetByteSize());
+
+    ResetState();
+    buffer.Clear(code);
+
+    // roughly one token per 4 bytes in typical lua code
+    buffer.Reserve(code->GetByteSize() / 4);
+
+    while (ReadBufferToken(buffer))
+    {
+    }
+
+    // swapped so the lexer keeps the cleared storage of the buffer for the next file
+    std::swap(buffer.diagnostics, diagnostics);
+    diagnostics.clear();
+}
+
+TokenBuffer BaseLexer::Relex(TokenBuffer previous, const Edit &edit)
+{
+    if (code->GetByteSize() > TokenBuffer::MAX_CODE_SIZE)
+        throw BaseLexer::Exception("code is too large for a token buffer", 0, code->GetByteSize());
+
+    auto shift = static_cast<ptrdiff_t>(edit.inserted) - static_cast<ptrdiff_t>(edit.removed);
+
+    // no token looks past a newline to decide where it ends, so the tokens that end before the
+    // newline preceding the edited line cannot change. resume from the first token after them
+    auto newline = edit.start == 0 ? std::string_view::npos : code->GetBuffer().rfind('\n', edit.start - 1);
+    size_t restart = 0;
+
+    if (newline != std::string_view::npos)
+    {
+        size_t low = 1;
+        size_t high = previous.Size();
+
+        while (low < high)
+        {
+            auto middle = low + (high - low) / 2;
+
+            if (previous.GetStop(middle - 1) <= newline)
+            {
+                restart = middle;
+                low = middle + 1;
+            }
+            else
             {
-                whitespace_token->value = code->GetStringSlice(whitespace_token->start, whitespace_token->stop);
+                high = middle;
             }
+        }
+    }
+
+    // except for unfinished long strings and comments, which only end early because nothing closes them up to
+    // the end of the code. resume from the token the first one before the restart belongs to
+    for (auto &diagnostic : previous.diagnostics)
+    {
+        if (diagnostic.start >= previous.GetBoundary(restart))
+            break;
+
+        if (!diagnostic.ReachesEndOfCode())
+            continue;
+
+        while (restart > 0 && previous.GetBoundary(restart) > diagnostic.start)
+            restart--;
 
-            token->value = code->GetStringSlice(token->start, token->stop);
-            token->whitespace = std::move(whitespace_tokens);
+        break;
+    }
+
+    auto boundary = previous.GetBoundary(restart);
+
+    diagnostics.clear();
+    position = boundary;
+    comment_escape = previous.GetState(restart) == TokenBuffer::State::InCommentEscape;
+
+    // lex until a boundary after the edit lines up with a boundary in previous while in the same state,
+    // from there on the remaining tokens are the same as before, only shifted
+    auto edit_stop = edit.start + edit.inserted;
+    auto resync = restart;
+    auto relexed = TokenBuffer(code);
+    bool synchronized = false;
+
+    while (ReadBufferToken(relexed))
+    {
+        if (position < edit_stop)
+            continue;
+
+        auto previous_position = static_cast<size_t>(position - shift);
+
+        while (resync < previous.Size() && previous.GetBoundary(resync) < previous_position)
+            resync++;
+
+        if (resync < previous.Size() &&
+            previous.GetBoundary(resync) == previous_position &&
+            previous.GetState(resync) == GetState())
+        {
+            synchronized = true;
+            break;
+        }
+    }
+
+    if (!synchronized)
+        resync = previous.Size();
 
-            whitespace_tokens = std::vector<std::unique_ptr<Token>>();
+    auto previous_position = previous.GetBoundary(resync);
+    auto kept = std::vector<LexerDiagnostic>();
 
-            return token;
+    for (auto diagnostic : previous.diagnostics)
+    {
+        if (diagnostic.start < boundary)
+        {
+            kept.push_back(diagnostic);
+        }
+        else if (synchronized && diagnostic.start >= previous_position)
+        {
+            diagnostic.start += shift;
+            diagnostic.stop += shift;
+            diagnostics.push_back(diagnostic);
         }
     }
+
+    kept.insert(kept.end(), diagnostics.begin(), diagnostics.end());
+    diagnostics.clear();
+
+    previous.Splice(restart, resync, relexed, shift);
+    previous.code = code;
+    previous.diagnostics = std::move(kept);
+
+    return previous;
 }
 
-std::pair<std::vector<std::unique_ptr<Token>>, std::vector<BaseLexer::Exception>> BaseLexer::GetTokens()
+void BaseLexer::ReadBufferChunk(TokenBuffer &buffer, size_t start, size_t stop)
 {
+    diagnostics.clear();
+    position = start;
+    comment_escape = false;
+
+    while (ReadBufferToken(buffer) && position < stop)
+    {
+    }
+
+    buffer.diagnostics = std::move(diagnostics);
+    diagnostics.clear();
+}
+
+TokenBuffer BaseLexer::GetTokenBufferInParallel(size_t thread_count, size_t min_chunk_size)
+{
+    if (code->GetByteSize() > TokenBuffer::MAX_CODE_SIZE)
+        throw BaseLexer::Exception("code is too large for a token buffer", 0, code->GetByteSize());
+
+    auto buffer_view = code->GetBuffer();
+    auto chunk_size = std::max(min_chunk_size, buffer_view.size() / std::max<size_t>(thread_count, 1));
+
+    // chunk i is [chunk_starts[i], chunk_starts[i + 1]), chunks start after a newline so most of them start between tokens
+    auto chunk_starts = std::vector<size_t>{0};
+
+    while (chunk_starts.back() + chunk_size < buffer_view.size())
+    {
+        auto newline = buffer_view.find('\n', chunk_starts.back() + chunk_size);
+
+        if (newline == std::string_view::npos || newline + 1 >= buffer_view.size())
+            break;
+
+        chunk_starts.push_back(newline + 1);
+    }
+
+    chunk_starts.push_back(buffer_view.size());
+
+    auto chunk_count = chunk_starts.size() - 1;
+
+    if (chunk_count == 1)
+        return GetTokenBuffer();
+
+    auto chunks = std::vector<TokenBuffer>(chunk_count, TokenBuffer(code));
+    auto chunk_end_states = std::vector<TokenBuffer::State>(chunk_count);
+    auto threads = std::vector<std::thread>();
+
+    for (size_t i = 1; i < chunk_count; i++)
+    {
+        threads.emplace_back([this, &chunks, &chunk_starts, &chunk_end_states, i]()
+                             {
+                                 auto lexer = Fork();
+                                 lexer->keep_whitespace = keep_whitespace;
+                                 lexer->decode_numbers = decode_numbers;
+                                 lexer->ReadBufferChunk(chunks[i], chunk_starts[i], chunk_starts[i + 1]);
+                                 chunk_end_states[i] = lexer->GetState(); });
+    }
+
     ResetState();
 
-    auto tokens = std::vector<std::unique_ptr<Token>>();
-    auto errors = std::vector<BaseLexer::Exception>();
+    auto buffer = TokenBuffer(code);
+    buffer.Reserve(buffer_view.size() / 4);
 
-    while (true)
+    // the first chunk starts at the beginning of the code so it is always right
+    ReadBufferChunk(buffer, 0, chunk_starts[1]);
+    auto merged_diagnostics = std::move(buffer.diagnostics);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    bool done = buffer.GetKind(buffer.Size() - 1) == Token::Kind::EndOfFile;
+
+    for (size_t i = 1; i < chunk_count && !done; i++)
     {
-        try
+        auto &chunk = chunks[i];
+        auto GetChunkBoundary = [&](size_t index)
+        { return index == 0 ? chunk_starts[i] : chunk.GetStop(index - 1); };
+
+        // position and comment_escape hold where the merged tokens end and the state there
+        size_t index = 0;
+        bool synchronized = false;
+
+        while (true)
         {
-            auto token = ReadToken();
-            auto kind = token->kind;
+            while (index < chunk.Size() && GetChunkBoundary(index) < position)
+                index++;
+
+            if (index < chunk.Size() && GetChunkBoundary(index) == position && chunk.GetState(index) == GetState())
+            {
+                synchronized = true;
+                break;
+            }
 
-            tokens.push_back(std::move(token));
+            if (position >= chunk_starts[i + 1])
+                break;
 
-            if (kind == Token::Kind::EndOfFile)
+            if (!ReadBufferToken(buffer))
             {
+                done = true;
                 break;
             }
         }
-        catch (BaseLexer::Exception &err)
+
+        merged_diagnostics.insert(merged_diagnostics.end(), diagnostics.begin(), diagnostics.end());
+        diagnostics.clear();
+
+        if (!synchronized)
+            continue;
+
+        auto boundary = position;
+
+        buffer.Append(chunk, index, chunk.Size());
+
+        for (auto &diagnostic : chunk.diagnostics)
         {
-            errors.push_back(err);
+            if (diagnostic.start >= boundary)
+                merged_diagnostics.push_back(diagnostic);
         }
+
+        position = buffer.GetStop(buffer.Size() - 1);
+        comment_escape = chunk_end_states[i] == TokenBuffer::State::InCommentEscape;
+        done = buffer.GetKind(buffer.Size() - 1) == Token::Kind::EndOfFile;
     }
 
-    return make_pair(std::move(tokens), errors);
+    buffer.diagnostics = std::move(merged_diagnostics);
+
+    return buffer;
 }
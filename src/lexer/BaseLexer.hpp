@@ -1,10 +1,15 @@
 #pragma once
 
 #include <cstdint>
+#include <iterator>
 #include "../code/Code.hpp"
+#include "../syntax/AtomTable.hpp"
 #include "../syntax/RuntimeSyntax.hpp"
 #include "../syntax/TypesystemSyntax.hpp"
+#include "./LexerDiagnostic.hpp"
+#include "./NumberLiteral.hpp"
 #include "./Token.hpp"
+#include "./TokenBuffer.hpp"
 
 class BaseLexer
 {
@@ -29,32 +34,104 @@ public:
         }
     };
 
+    // reads one token at a time with ReadToken, the last token is EndOfFile
+    class TokenIterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::unique_ptr<Token>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::unique_ptr<Token> *;
+        using reference = std::unique_ptr<Token> &;
+
+        explicit TokenIterator(BaseLexer *lexer);
+        std::unique_ptr<Token> &operator*() { return current; }
+        TokenIterator &operator++();
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return finished; }
+
+    private:
+        BaseLexer *lexer;
+        std::unique_ptr<Token> current;
+        uint32_t index = 0;
+        // remembered separately because the caller may move current out
+        bool at_end_of_file = false;
+        bool finished = false;
+    };
+
+    // the bytes [start, start + removed) of the previous code were replaced by inserted new bytes
+    struct Edit
+    {
+        size_t start;
+        size_t removed;
+        size_t inserted;
+    };
+
     std::shared_ptr<Code> code;
     size_t position = 0;
-    RuntimeSyntax *runtime_syntax = new RuntimeSyntax();
-    TypesystemSyntax *typesystem_syntax = new TypesystemSyntax();
+    std::vector<LexerDiagnostic> diagnostics;
+    // number tokens get their value decoded as they are read, see Token::number and TokenBuffer::numbers
+    bool decode_numbers = true;
+    // when false, spaces and comments are skipped without being stored in Token::whitespace or TokenBuffer
+    // comment escapes still switch the lexer state, only the trivia itself is dropped
+    bool keep_whitespace = true;
+    // the value of the last number token
+    NumberValue number;
+    const RuntimeSyntax *runtime_syntax = &RuntimeSyntax::Get();
+    const TypesystemSyntax *typesystem_syntax = &TypesystemSyntax::Get();
 
-    virtual std::unique_ptr<Token> ReadNonWhitespaceToken() = 0;
-    virtual std::unique_ptr<Token> ReadWhitespaceToken() = 0;
+    // a new lexer of the same type over the same code
+    virtual std::unique_ptr<BaseLexer> Fork() = 0;
+    virtual std::optional<Token::Kind> ReadNonWhitespaceToken() = 0;
+    virtual std::optional<Token::Kind> ReadWhitespaceToken() = 0;
 
     std::unique_ptr<Token> ReadToken();
-    std::unique_ptr<Token> ReadShebang();
-    std::unique_ptr<Token> ReadUnknown();
-    std::unique_ptr<Token> ReadEndOfFile();
-    std::unique_ptr<Token> ReadCommentEscape();
-    std::unique_ptr<Token> ReadRemainingCommentEscape();
+    Token::Kind ReadTokenKind();
+    std::optional<Token::Kind> ReadShebang();
+    Token::Kind ReadUnknown();
+    std::optional<Token::Kind> ReadEndOfFile();
+    std::optional<Token::Kind> ReadCommentEscape();
+    std::optional<Token::Kind> ReadRemainingCommentEscape();
     std::pair<std::vector<std::unique_ptr<Token>>, std::vector<BaseLexer::Exception>> GetTokens();
+    std::vector<BaseLexer::Exception> GetErrors();
+
+    // starts lexing from the beginning of the code
+    TokenIterator begin();
+    std::default_sentinel_t end() { return std::default_sentinel; }
+    TokenBuffer GetTokenBuffer();
+    // same as above but fills a buffer from an earlier file, reusing its memory
+    void GetTokenBuffer(TokenBuffer &buffer);
+    // code must already contain the edit, previous must be the token buffer of the code before it
+    // only the tokens around the edit are lexed again and spliced into previous
+    TokenBuffer Relex(TokenBuffer previous, const Edit &edit);
+    // splits the code into chunks at newlines and lexes them on separate threads as if each started outside of
+    // any string or comment. chunks where that guess was wrong are lexed again from where the previous one ended
+    // the result is the same as GetTokenBuffer
+    TokenBuffer GetTokenBufferInParallel(size_t thread_count, size_t min_chunk_size = 1 << 20);
 
     std::string_view GetRelativeStringSlice(size_t start, size_t stop);
     uint8_t GetByte(size_t offset = 0);
     bool IsString(std::string_view value, const size_t relative_offset = 0);
     void ResetState();
+    // lexes other code from the start, keeping the atom cache and diagnostic storage of this lexer
+    void Reset(std::shared_ptr<Code> code);
+    Token::Kind Error(LexerDiagnostic::Code code, size_t start, size_t stop);
+    // interns Letter and Symbol tokens, Atom::None for everything else
+    Atom::Id GetAtom(Token::Kind kind, std::string_view value);
     std::optional<size_t> FindNearest(std::string_view pattern);
     uint8_t ReadByte();
     bool TheEnd();
-    bool ReadFirstFromStringArray(std::vector<std::string> array);
+    size_t MatchLongest(const SymbolMatcher &matcher);
+    bool ReadLongestMatch(const SymbolMatcher &matcher);
 
 private:
+    friend class TriviaReader;
+
     bool comment_escape = false;
-    std::unique_ptr<Token> ReadSingleToken();
+    AtomCache atom_cache;
+    TokenBuffer::State GetState();
+    // reads the next token with its whitespace into buffer, returns false once EndOfFile was added
+    bool ReadBufferToken(TokenBuffer &buffer);
+    // reads tokens from start until one ends at or after stop
+    void ReadBufferChunk(TokenBuffer &buffer, size_t start, size_t stop);
 };
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "./LexerDiagnostic.hpp"
+
+static std::string_view GetByteAt(std::string_view source, size_t index)
+{
+    if (index >= source.size())
+        return "";
+
+    return source.substr(index, 1);
+}
+
+std::string LexerDiagnostic::GetMessage(std::string_view source) const
+{
+    switch (code)
+    {
+    case MalformedHexNumber:
+        return "malformed hex number, got " + std::string(GetByteAt(source, stop));
+    case MalformedBinaryNumber:
+        return "malformed binary number, got " + std::string(GetByteAt(source, stop));
+    case MalformedDecimalNumber:
+        return "malformed decimal number, got " + std::string(GetByteAt(source, stop));
+    case ExpectedExponentSign:
+        return "expected + or - after exponent, got " + std::string(GetByteAt(source, stop));
+    case ExpectedPowSign:
+        return "expected + or - after pow, got " + std::string(GetByteAt(source, stop));
+    case MalformedExponent:
+        return "malformed 'exponent' expected number, got " + std::string(GetByteAt(source, stop + 1));
+    case MalformedPow:
+        return "malformed 'pow' expected number, got " + std::string(GetByteAt(source, stop + 1));
+    case MalformedMultilineString:
+        return "malformed multiline string: expected =, got " + std::string(GetByteAt(source, stop));
+    case UnfinishedMultilineString:
+        return "expected multiline string to end, reached end of code";
+    case UnfinishedMultilineComment:
+        return "expected multiline comment to end, reached end of code";
+    case UnfinishedMultilineCComment:
+        return "expected multiline C comment to end, reached end of code";
+    case UnfinishedStringNewline:
+        return "expected ending " + std::string(GetByteAt(source, start)) + " quote, got newline";
+    case UnfinishedString:
+        return "expected ending " + std::string(GetByteAt(source, start)) + " quote, reached end of code";
+    case MalformedUtf8Escape:
+        return "malformed \\u{XXX} escape, expected hex digits for a value up to 7FFFFFFF";
+    }
+
+    return "unknown error";
+}
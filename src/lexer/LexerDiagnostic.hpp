@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// a lexing error, the message is only built when asked for
+struct LexerDiagnostic
+{
+    enum Code : uint8_t
+    {
+        MalformedHexNumber,
+        MalformedBinaryNumber,
+        MalformedDecimalNumber,
+        ExpectedExponentSign,
+        ExpectedPowSign,
+        MalformedExponent,
+        MalformedPow,
+        MalformedMultilineString,
+        UnfinishedMultilineString,
+        UnfinishedMultilineComment,
+        UnfinishedMultilineCComment,
+        UnfinishedStringNewline,
+        UnfinishedString,
+        MalformedUtf8Escape,
+    };
+
+    Code code;
+    uint32_t start;
+    uint32_t stop;
+
+    std::string GetMessage(std::string_view source) const;
+
+    // the error was only found at the end of the code, so text anywhere after start can change it
+    bool ReachesEndOfCode() const
+    {
+        return code == UnfinishedMultilineString || code == UnfinishedMultilineComment || code == UnfinishedMultilineCComment || code == UnfinishedString;
+    }
+};
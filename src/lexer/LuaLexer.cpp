@@ -1,51 +1,40 @@
 #include "./LuaLexer.hpp"
 #include "../syntax/CharacterClasses.hpp"
-#include <sstream>
+#include "./ScanKernels.hpp"
+#include "./StringLiteral.hpp"
 
-std::unique_ptr<Token> LuaLexer::ReadSpace()
+std::optional<Token::Kind> LuaLexer::ReadSpace()
 {
     if (!IsSpace(GetByte()))
-        return nullptr;
+        return std::nullopt;
 
-    while (!TheEnd())
-    {
-        position += 1;
-
-        if (!IsSpace(GetByte()))
-            break;
-    }
+    position = ScanKernels::SkipSpace(code->GetBuffer(), position + 1);
 
-    return std::make_unique<Token>(Token::Kind::Space);
+    return Token::Kind::Space;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadLetter()
+std::optional<Token::Kind> LuaLexer::ReadLetter()
 {
     if (!IsLetter(GetByte()))
-        return nullptr;
+        return std::nullopt;
 
-    while (!TheEnd())
-    {
-        position += 1;
-
-        if (!IsDuringLetter(GetByte()))
-            break;
-    }
+    position = ScanKernels::SkipDuringLetter(code->GetBuffer(), position + 1);
 
-    return std::make_unique<Token>(Token::Kind::Letter);
+    return Token::Kind::Letter;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadSymbol()
+std::optional<Token::Kind> LuaLexer::ReadSymbol()
 {
-    if (!ReadFirstFromStringArray(runtime_syntax->GetSymbols()) && !ReadFirstFromStringArray(typesystem_syntax->GetSymbols()))
-        return nullptr;
+    if (!ReadLongestMatch(runtime_syntax->GetSymbolMatcher()) && !ReadLongestMatch(typesystem_syntax->GetSymbolMatcher()))
+        return std::nullopt;
 
-    return std::make_unique<Token>(Token::Kind::Symbol);
+    return Token::Kind::Symbol;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadMultilineCComment()
+std::optional<Token::Kind> LuaLexer::ReadMultilineCComment()
 {
     if (!IsString("/*"))
-        return nullptr;
+        return std::nullopt;
 
     auto start = position;
     position += 2;
@@ -55,62 +44,43 @@ std::unique_ptr<Token> LuaLexer::ReadMultilineCComment()
         if (IsString("*/"))
         {
             position += 2;
-            return std::make_unique<Token>(Token::Kind::MultilineComment);
+            return Token::Kind::MultilineComment;
         }
 
         position += 1;
     }
 
-    throw BaseLexer::Exception("expected multiline C comment to end, reached end of code", start, position);
+    return Error(LexerDiagnostic::UnfinishedMultilineCComment, start, position);
 }
 
-std::unique_ptr<Token> LuaLexer::ReadLineComment()
+std::optional<Token::Kind> LuaLexer::ReadLineComment()
 {
     if (!IsString("--"))
-        return nullptr;
+        return std::nullopt;
 
     position += 2;
 
-    while (!TheEnd())
-    {
-        if (IsString("\n"))
-            break;
-
-        position += 1;
-    }
+    position = ScanKernels::FindNewline(code->GetBuffer(), position);
 
-    return std::make_unique<Token>(Token::Kind::LineComment);
+    return Token::Kind::LineComment;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadLineCComment()
+std::optional<Token::Kind> LuaLexer::ReadLineCComment()
 {
     if (!IsString("//"))
-        return nullptr;
+        return std::nullopt;
 
     position += 2;
 
-    while (!TheEnd())
-    {
-        if (IsString("\n"))
-            break;
+    position = ScanKernels::FindNewline(code->GetBuffer(), position);
 
-        position += 1;
-    }
-
-    return std::make_unique<Token>(Token::Kind::LineComment);
-}
-
-std::string repeat(const std::string &input, size_t num)
-{
-    std::ostringstream os;
-    std::fill_n(std::ostream_iterator<std::string>(os), num, input);
-    return os.str();
+    return Token::Kind::LineComment;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadMultilineComment()
+std::optional<Token::Kind> LuaLexer::ReadMultilineComment()
 {
-    if (!IsString("--[") || (!IsString("[", 3) && !IsString("=", 3)))
-        return nullptr;
+    if (!IsString("--[") || (GetByte(3) != '[' && GetByte(3) != '='))
+        return std::nullopt;
 
     auto start = position;
 
@@ -118,11 +88,11 @@ std::unique_ptr<Token> LuaLexer::ReadMultilineComment()
     position += 3;
 
     // skip all the =
-    while (IsString("="))
+    while (GetByte() == '=')
         position += 1;
 
     // if we have an incomplete multiline comment, it's just a single line comment
-    if (!IsString("["))
+    if (GetByte() != '[')
     {
         position = start;
         return ReadLineComment();
@@ -130,71 +100,64 @@ std::unique_ptr<Token> LuaLexer::ReadMultilineComment()
 
     // skip the last [
     position += 1;
-    auto pos = position;
 
-    auto closing = std::string("]" + repeat("=", pos - start - 4) + "]");
-    auto pos2 = FindNearest(closing);
+    auto level = position - start - 4;
+    auto closing = ScanKernels::FindClosingLongBracket(code->GetBuffer(), position, level);
 
-    if (pos2.has_value())
+    if (closing < code->GetByteSize())
     {
-        position = pos2.value() + closing.size();
-        return std::make_unique<Token>(Token::Kind::MultilineComment);
+        position = closing + level + 2;
+        return Token::Kind::MultilineComment;
     }
 
-    position = start + 2;
-
-    throw BaseLexer::Exception("expected multiline comment to end, reached end of code", start, start + 1);
+    // only the opening bracket becomes an error, lexing continues after it
+    return Error(LexerDiagnostic::UnfinishedMultilineComment, start, start + 1);
 }
 
-std::unique_ptr<Token> LuaLexer::ReadAnalyzerDebugCode()
+std::optional<Token::Kind> LuaLexer::ReadAnalyzerDebugCode()
 {
     if (!IsString("§"))
-        return nullptr;
+        return std::nullopt;
 
     position += 2;
 
-    while (!TheEnd())
-    {
-        if (IsString("\n"))
-            break;
-
-        position += 1;
-    }
+    position = ScanKernels::FindNewline(code->GetBuffer(), position);
 
-    return std::make_unique<Token>(Token::Kind::AnalyzerDebugCode);
+    return Token::Kind::AnalyzerDebugCode;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadParserDebugCode()
+std::optional<Token::Kind> LuaLexer::ReadParserDebugCode()
 {
     if (!IsString("£"))
-        return nullptr;
+        return std::nullopt;
 
     position += 2;
 
-    while (!TheEnd())
-    {
-        if (IsString("\n"))
-            break;
+    position = ScanKernels::FindNewline(code->GetBuffer(), position);
 
-        position += 1;
-    }
-
-    return std::make_unique<Token>(Token::Kind::ParserDebugCode);
+    return Token::Kind::ParserDebugCode;
 }
 
-bool ReadNumberExponent(LuaLexer &lexer, std::string_view what)
+// returns false and records the error if the exponent is malformed
+bool ReadNumberExponent(LuaLexer &lexer, bool pow)
 {
     // skip the 'e', 'E', 'p' or 'P'
     lexer.position += 1;
 
-    if (!lexer.IsString("+") && !lexer.IsString("-"))
-        throw BaseLexer::Exception("expected + or - after " + std::string(what) + ", got " + std::string(lexer.GetRelativeStringSlice(0, 1)), lexer.position - 1, lexer.position);
+    if (lexer.GetByte() != '+' && lexer.GetByte() != '-')
+    {
+        lexer.Error(pow ? LexerDiagnostic::ExpectedPowSign : LexerDiagnostic::ExpectedExponentSign, lexer.position - 1, lexer.position);
+        return false;
+    }
 
     // skip the '+' or '-'
     lexer.position += 1;
 
     if (!IsNumber(lexer.GetByte()))
-        throw BaseLexer::Exception("malformed '" + std::string(what) + "' expected number, got " + std::string(lexer.GetRelativeStringSlice(0, 1)), lexer.position - 2, lexer.position - 1);
+    {
+        lexer.Error(pow ? LexerDiagnostic::MalformedPow : LexerDiagnostic::MalformedExponent, lexer.position - 2, lexer.position - 1);
+        return false;
+    }
 
     while (!lexer.TheEnd())
     {
@@ -207,20 +170,30 @@ bool ReadNumberExponent(LuaLexer &lexer, std::string_view what)
     return true;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadHexNumber()
+Token::Kind LuaLexer::ReadMalformedNumber()
 {
-    if (!IsString("0") || (!IsString("x", 1) && !IsString("X", 1)))
-        return nullptr;
+    // the rest of the word belongs to the broken number
+    position = ScanKernels::SkipDuringLetter(code->GetBuffer(), position);
+
+    return Token::Kind::Error;
+}
+
+std::optional<Token::Kind> LuaLexer::ReadHexNumber()
+{
+    if (GetByte() != '0' || (GetByte(1) != 'x' && GetByte(1) != 'X'))
+        return std::nullopt;
+
+    auto start = position;
 
     // skip past 0x
     position += 2;
 
     while (!TheEnd())
     {
-        if (IsString("_"))
+        if (GetByte() == '_')
             position += 1;
 
-        if (IsString(".") && !IsString(".", 1))
+        if (GetByte() == '.' && GetByte(1) != '.')
             position += 1;
 
         if (IsValidHex(GetByte()))
@@ -233,35 +206,47 @@ std::unique_ptr<Token> LuaLexer::ReadHexNumber()
             if (IsSpace(GetByte()) || IsSymbol(GetByte()))
                 break;
 
-            if (IsString("p") || IsString("P"))
+            // 50ull, 2i
+            if (MatchLongest(runtime_syntax->GetNumberAnnotationMatcher()))
+                break;
+
+            if (GetByte() == 'p' || GetByte() == 'P')
             {
-                if (ReadNumberExponent(*this, "pow"))
+                if (ReadNumberExponent(*this, true))
                     break;
+
+                return ReadMalformedNumber();
             }
 
-            throw BaseLexer::Exception("malformed hex number, got " + std::string(GetRelativeStringSlice(0, 1)), position - 1, position);
+            Error(LexerDiagnostic::MalformedHexNumber, position - 1, position);
+            return ReadMalformedNumber();
         }
     }
 
-    ReadFirstFromStringArray(runtime_syntax->GetNumberAnnotations());
+    ReadLongestMatch(runtime_syntax->GetNumberAnnotationMatcher());
+
+    if (decode_numbers)
+        number = NumberLiteral::DecodeHex(code->GetStringSlice(start, position));
 
-    return std::make_unique<Token>(Token::Kind::Number);
+    return Token::Kind::Number;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadBinaryNumber()
+std::optional<Token::Kind> LuaLexer::ReadBinaryNumber()
 {
-    if (!IsString("0") || (!IsString("b", 1) && !IsString("B", 1)))
-        return nullptr;
+    if (GetByte() != '0' || (GetByte(1) != 'b' && GetByte(1) != 'B'))
+        return std::nullopt;
+
+    auto start = position;
 
     // skip past 0b
     position += 2;
 
     while (!TheEnd())
     {
-        if (IsString("_"))
+        if (GetByte() == '_')
             position += 1;
 
-        if (IsString("1") || IsString("0"))
+        if (GetByte() == '1' || GetByte() == '0')
         {
             position += 1;
         }
@@ -270,30 +255,42 @@ std::unique_ptr<Token> LuaLexer::ReadBinaryNumber()
             if (IsSpace(GetByte()) || IsSymbol(GetByte()))
                 break;
 
-            if (IsString("e") || IsString("E"))
+            // 50ull, 2i
+            if (MatchLongest(runtime_syntax->GetNumberAnnotationMatcher()))
+                break;
+
+            if (GetByte() == 'e' || GetByte() == 'E')
             {
-                if (ReadNumberExponent(*this, "exponent"))
+                if (ReadNumberExponent(*this, false))
                     break;
+
+                return ReadMalformedNumber();
             }
 
-            throw BaseLexer::Exception("malformed binary number, got " + std::string(GetRelativeStringSlice(0, 1)), position - 1, position);
+            Error(LexerDiagnostic::MalformedBinaryNumber, position - 1, position);
+            return ReadMalformedNumber();
         }
     }
 
-    ReadFirstFromStringArray(runtime_syntax->GetNumberAnnotations());
+    ReadLongestMatch(runtime_syntax->GetNumberAnnotationMatcher());
 
-    return std::make_unique<Token>(Token::Kind::Number);
+    if (decode_numbers)
+        number = NumberLiteral::DecodeBinary(code->GetStringSlice(start, position));
+
+    return Token::Kind::Number;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadDecimalNumber()
+std::optional<Token::Kind> LuaLexer::ReadDecimalNumber()
 {
-    if (!IsNumber(GetByte()) && (!IsString(".") || !IsNumber(GetByte(1))))
-        return nullptr;
+    if (!IsNumber(GetByte()) && (GetByte() != '.' || !IsNumber(GetByte(1))))
+        return std::nullopt;
+
+    auto start = position;
 
     // if we start with a dot
     // .0
     auto has_dot = false;
-    if (IsString("."))
+    if (GetByte() == '.')
     {
         has_dot = true;
         position += 1;
@@ -301,14 +298,14 @@ std::unique_ptr<Token> LuaLexer::ReadDecimalNumber()
 
     while (!TheEnd())
     {
-        if (IsString("_"))
+        if (GetByte() == '_')
             position += 1;
 
-        if (!has_dot && IsString("."))
+        if (!has_dot && GetByte() == '.')
         {
             // 22..66 would be a number range
             // so we have to return 22 only
-            if (IsString(".", 1))
+            if (GetByte(1) == '.')
                 break;
 
             has_dot = true;
@@ -324,156 +321,249 @@ std::unique_ptr<Token> LuaLexer::ReadDecimalNumber()
             if (IsSpace(GetByte()) || IsSymbol(GetByte()))
                 break;
 
-            if (IsString("e") || IsString("E"))
+            // 50ull, 2i
+            if (MatchLongest(runtime_syntax->GetNumberAnnotationMatcher()))
+                break;
+
+            if (GetByte() == 'e' || GetByte() == 'E')
             {
-                if (ReadNumberExponent(*this, "exponent"))
+                if (ReadNumberExponent(*this, false))
                     break;
+
+                return ReadMalformedNumber();
             }
 
-            throw BaseLexer::Exception("malformed decimal number, got " + std::string(GetRelativeStringSlice(0, 1)), position - 1, position);
+            Error(LexerDiagnostic::MalformedDecimalNumber, position - 1, position);
+            return ReadMalformedNumber();
         }
     }
 
-    ReadFirstFromStringArray(runtime_syntax->GetNumberAnnotations());
+    ReadLongestMatch(runtime_syntax->GetNumberAnnotationMatcher());
 
-    return std::make_unique<Token>(Token::Kind::Number);
+    if (decode_numbers)
+        number = NumberLiteral::DecodeDecimal(code->GetStringSlice(start, position));
+
+    return Token::Kind::Number;
 }
 
-std::unique_ptr<Token> LuaLexer::ReadMultilineString()
+std::optional<Token::Kind> LuaLexer::ReadMultilineString()
 {
-    if (!IsString("[", 0) || (!IsString("[", 1) && !IsString("=", 1)))
-        return nullptr;
+    if (GetByte() != '[' || (GetByte(1) != '[' && GetByte(1) != '='))
+        return std::nullopt;
 
     auto start = position;
     position += 1;
 
-    if (IsString("=", 0))
+    if (GetByte() == '=')
     {
         while (!TheEnd())
         {
             position += 1;
-            if (!IsString("=", 0))
+            if (GetByte() != '=')
                 break;
         }
     }
 
-    if (!IsString("[", 0))
-        throw BaseLexer::Exception("malformed multiline string: expected =, got " + std::string(GetRelativeStringSlice(0, 1)), start, position);
+    if (GetByte() != '[')
+        return Error(LexerDiagnostic::MalformedMultilineString, start, position);
 
     position += 1;
-    auto pos = position;
 
-    auto closing = std::string("]" + repeat("=", pos - start - 2) + "]");
-    auto pos2 = FindNearest(closing);
+    auto level = position - start - 2;
+    auto closing = ScanKernels::FindClosingLongBracket(code->GetBuffer(), position, level);
 
-    if (pos2.has_value())
+    if (closing < code->GetByteSize())
     {
-        position = pos2.value() + closing.size();
-        return std::make_unique<Token>(Token::Kind::String);
+        position = closing + level + 2;
+        return Token::Kind::String;
     }
 
-    throw BaseLexer::Exception("expected multiline string to end, reached end of code", start, position);
+    // only the opening bracket becomes an error, lexing continues after it
+    return Error(LexerDiagnostic::UnfinishedMultilineString, start, position);
 }
 
-std::unique_ptr<Token> ReadQuotedString(LuaLexer &lexer, const char quote)
+std::optional<Token::Kind> ReadQuotedString(LuaLexer &lexer, const char quote)
 {
     if (lexer.GetByte() != quote)
-        return nullptr;
+        return std::nullopt;
 
     auto const start = lexer.position;
     lexer.position += 1;
 
-    while (!lexer.TheEnd())
+    while (true)
     {
+        lexer.position = ScanKernels::FindQuotedStringEnd(lexer.code->GetBuffer(), lexer.position, quote);
+
+        if (lexer.TheEnd())
+            break;
+
         auto const byte = lexer.ReadByte();
 
-        if (byte == '\\' && lexer.IsString("z"))
+        if (byte == '\\')
         {
-            // skip past \z
-            lexer.position += 1;
+            if (lexer.GetByte() == 'z')
+            {
+                // skip past \z
+                lexer.position += 1;
+
+                lexer.ReadSpace();
+            }
+            else if (lexer.GetByte() == 'u')
+            {
+                uint32_t code_point;
 
-            lexer.ReadSpace();
+                // the string is still read to its end, only the escape is reported
+                if (!StringLiteral::ReadUtf8Escape(lexer.code->GetBuffer().substr(lexer.position + 1), code_point))
+                    lexer.Error(LexerDiagnostic::MalformedUtf8Escape, lexer.position - 1, lexer.position + 1);
+
+                lexer.position += 1;
+            }
+            else if (!lexer.TheEnd())
+            {
+                // skip the escaped character, so \" and \\ don't end the string
+                lexer.position += 1;
+            }
         }
         else if (byte == '\n')
         {
-            throw BaseLexer::Exception("expected ending " + std::string(1, quote) + " quote, got newline", start, lexer.position);
+            // the newline is left for the next token
+            lexer.position -= 1;
+            return lexer.Error(LexerDiagnostic::UnfinishedStringNewline, start, lexer.position + 1);
         }
-        else if (byte == quote)
+        else
         {
-            return std::make_unique<Token>(Token::Kind::String);
+            return Token::Kind::String;
         }
     }
 
-    throw BaseLexer::Exception("expected ending " + std::string(1, quote) + " quote, reached end of code", start, lexer.position - 1);
+    return lexer.Error(LexerDiagnostic::UnfinishedString, start, lexer.position - 1);
 }
 
-std::unique_ptr<Token> LuaLexer::ReadSingleQuotedString()
+std::optional<Token::Kind> LuaLexer::ReadSingleQuotedString()
 {
     return ReadQuotedString(*this, '\'');
 }
 
-std::unique_ptr<Token> LuaLexer::ReadDoubleQuotedString()
+std::optional<Token::Kind> LuaLexer::ReadDoubleQuotedString()
 {
     return ReadQuotedString(*this, '"');
 }
 
-std::unique_ptr<Token> LuaLexer::ReadNonWhitespaceToken()
+std::array<LuaLexer::Scanner, 256> LuaLexer::BuildScannerTable()
 {
-    if (auto res = ReadAnalyzerDebugCode())
-        return res;
+    auto scanners = std::array<Scanner, 256>();
+    scanners.fill(Scanner::None);
 
-    if (auto res = ReadParserDebugCode())
-        return res;
+    for (auto &symbol : RuntimeSyntax::Get().GetSymbols())
+        scanners[static_cast<uint8_t>(symbol[0])] = Scanner::Symbol;
 
-    if (auto res = ReadHexNumber())
-        return res;
+    for (auto &symbol : TypesystemSyntax::Get().GetSymbols())
+        scanners[static_cast<uint8_t>(symbol[0])] = Scanner::Symbol;
 
-    if (auto res = ReadBinaryNumber())
-        return res;
+    for (size_t c = 0; c < scanners.size(); c++)
+    {
+        if (IsSpace(c))
+            scanners[c] = Scanner::Space;
+        else if (IsNumber(c))
+            scanners[c] = Scanner::Number;
+        else if (IsLetter(c))
+            scanners[c] = Scanner::Letter;
+    }
 
-    if (auto res = ReadDecimalNumber())
-        return res;
+    scanners['.'] = Scanner::Dot;
+    scanners['['] = Scanner::Bracket;
+    scanners['\''] = Scanner::SingleQuote;
+    scanners['"'] = Scanner::DoubleQuote;
+    scanners['-'] = Scanner::Dash;
+    scanners['/'] = Scanner::Slash;
 
-    if (auto res = ReadMultilineString())
-        return res;
+    // § and £ are 0xC2 0xA7 and 0xC2 0xA3 in utf8
+    scanners[0xC2] = Scanner::DebugCode;
 
-    if (auto res = ReadSingleQuotedString())
-        return res;
+    return scanners;
+}
 
-    if (auto res = ReadDoubleQuotedString())
-        return res;
+const std::array<LuaLexer::Scanner, 256> LuaLexer::scanners = LuaLexer::BuildScannerTable();
 
-    if (auto res = ReadLetter())
-        return res;
+std::optional<Token::Kind> LuaLexer::ReadNonWhitespaceToken()
+{
+    switch (scanners[GetByte()])
+    {
+    case Scanner::Letter:
+        return ReadLetter();
 
-    if (auto res = ReadSymbol())
-        return res;
+    case Scanner::Number:
+        if (auto res = ReadHexNumber())
+            return res;
+
+        if (auto res = ReadBinaryNumber())
+            return res;
+
+        return ReadDecimalNumber();
+
+    case Scanner::Dot:
+        if (auto res = ReadDecimalNumber())
+            return res;
+
+        return ReadSymbol();
+
+    case Scanner::Bracket:
+        if (auto res = ReadMultilineString())
+            return res;
+
+        return ReadSymbol();
+
+    case Scanner::SingleQuote:
+        return ReadSingleQuotedString();
+
+    case Scanner::DoubleQuote:
+        return ReadDoubleQuotedString();
+
+    case Scanner::Dash:
+    case Scanner::Slash:
+    case Scanner::Symbol:
+        return ReadSymbol();
 
-    return nullptr;
+    case Scanner::DebugCode:
+        if (auto res = ReadAnalyzerDebugCode())
+            return res;
+
+        if (auto res = ReadParserDebugCode())
+            return res;
+
+        return ReadLetter();
+
+    default:
+        return std::nullopt;
+    }
 }
 
-std::unique_ptr<Token> LuaLexer::ReadWhitespaceToken()
+std::optional<Token::Kind> LuaLexer::ReadWhitespaceToken()
 {
     if (auto res = ReadRemainingCommentEscape())
         return res;
 
-    if (auto res = ReadSpace())
-        return res;
+    switch (scanners[GetByte()])
+    {
+    case Scanner::Space:
+        return ReadSpace();
 
-    if (auto res = ReadCommentEscape())
-        return res;
+    case Scanner::Dash:
+        if (auto res = ReadCommentEscape())
+            return res;
 
-    if (auto res = ReadMultilineCComment())
-        return res;
+        if (auto res = ReadMultilineComment())
+            return res;
 
-    if (auto res = ReadLineCComment())
-        return res;
+        return ReadLineComment();
 
-    if (auto res = ReadMultilineComment())
-        return res;
+    case Scanner::Slash:
+        if (auto res = ReadMultilineCComment())
+            return res;
 
-    if (auto res = ReadLineComment())
-        return res;
+        return ReadLineCComment();
 
-    return nullptr;
-}
+    default:
+        return std::nullopt;
+    }
+}
\ No newline at end of file
@@ -1,9 +1,27 @@
 #pragma once
+#include <array>
 #include "./BaseLexer.hpp"
 
 class LuaLexer : public BaseLexer
 {
 public:
+    // which readers a token starting with a given byte can come from
+    enum class Scanner : uint8_t
+    {
+        None,
+        Space,
+        Letter,
+        Number,
+        Dot,
+        Bracket,
+        SingleQuote,
+        DoubleQuote,
+        Dash,
+        Slash,
+        Symbol,
+        DebugCode,
+    };
+
     explicit LuaLexer(std::shared_ptr<Code> code)
     {
         this->code = code;
@@ -12,21 +30,28 @@ public:
     {
     }
 
-    std::unique_ptr<Token> ReadNonWhitespaceToken() override;
-    std::unique_ptr<Token> ReadWhitespaceToken() override;
-    std::unique_ptr<Token> ReadMultilineComment();
-    std::unique_ptr<Token> ReadLineCComment();
-    std::unique_ptr<Token> ReadMultilineCComment();
-    std::unique_ptr<Token> ReadLineComment();
-    std::unique_ptr<Token> ReadParserDebugCode();
-    std::unique_ptr<Token> ReadHexNumber();
-    std::unique_ptr<Token> ReadBinaryNumber();
-    std::unique_ptr<Token> ReadDecimalNumber();
-    std::unique_ptr<Token> ReadMultilineString();
-    std::unique_ptr<Token> ReadSingleQuotedString();
-    std::unique_ptr<Token> ReadDoubleQuotedString();
-    std::unique_ptr<Token> ReadLetter();
-    std::unique_ptr<Token> ReadSymbol();
-    std::unique_ptr<Token> ReadSpace();
-    std::unique_ptr<Token> ReadAnalyzerDebugCode();
+    std::unique_ptr<BaseLexer> Fork() override { return std::make_unique<LuaLexer>(code); }
+    std::optional<Token::Kind> ReadNonWhitespaceToken() override;
+    std::optional<Token::Kind> ReadWhitespaceToken() override;
+    std::optional<Token::Kind> ReadMultilineComment();
+    std::optional<Token::Kind> ReadLineCComment();
+    std::optional<Token::Kind> ReadMultilineCComment();
+    std::optional<Token::Kind> ReadLineComment();
+    std::optional<Token::Kind> ReadParserDebugCode();
+    std::optional<Token::Kind> ReadHexNumber();
+    std::optional<Token::Kind> ReadBinaryNumber();
+    std::optional<Token::Kind> ReadDecimalNumber();
+    std::optional<Token::Kind> ReadMultilineString();
+    std::optional<Token::Kind> ReadSingleQuotedString();
+    std::optional<Token::Kind> ReadDoubleQuotedString();
+    std::optional<Token::Kind> ReadLetter();
+    std::optional<Token::Kind> ReadSymbol();
+    std::optional<Token::Kind> ReadSpace();
+    std::optional<Token::Kind> ReadAnalyzerDebugCode();
+    Token::Kind ReadMalformedNumber();
+
+private:
+    // shared by all lexers, built from the syntax tables at startup
+    static const std::array<Scanner, 256> scanners;
+    static std::array<Scanner, 256> BuildScannerTable();
 };
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "./NumberLiteral.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+double NumberValue::ToDouble() const
+{
+    switch (suffix)
+    {
+    case Suffix::LL:
+        return static_cast<double>(integer);
+    case Suffix::ULL:
+    case Suffix::UL:
+        return static_cast<double>(unsigned_integer);
+    default:
+        return number;
+    }
+}
+
+namespace
+{
+    inline uint8_t Lower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+
+    bool EndsWith(std::string_view text, std::string_view suffix)
+    {
+        if (text.size() < suffix.size())
+            return false;
+
+        for (size_t i = 0; i < suffix.size(); i++)
+        {
+            if (Lower(text[text.size() - suffix.size() + i]) != suffix[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    // removes the annotation from the end of text
+    NumberValue::Suffix StripSuffix(std::string_view &text)
+    {
+        if (EndsWith(text, "ull"))
+        {
+            text.remove_suffix(3);
+            return NumberValue::Suffix::ULL;
+        }
+
+        if (EndsWith(text, "ul"))
+        {
+            text.remove_suffix(2);
+            return NumberValue::Suffix::UL;
+        }
+
+        if (EndsWith(text, "ll"))
+        {
+            text.remove_suffix(2);
+            return NumberValue::Suffix::LL;
+        }
+
+        if (EndsWith(text, "i"))
+        {
+            text.remove_suffix(1);
+            return NumberValue::Suffix::I;
+        }
+
+        return NumberValue::Suffix::None;
+    }
+
+    // text without _ separators, only copies when there are any
+    class Digits
+    {
+    public:
+        explicit Digits(std::string_view text)
+        {
+            if (text.find('_') == std::string_view::npos)
+            {
+                view = text;
+                return;
+            }
+
+            for (auto c : text)
+            {
+                if (c != '_')
+                    copy.push_back(c);
+            }
+
+            view = copy;
+        }
+
+        std::string_view view;
+
+    private:
+        std::string copy;
+    };
+
+    double ParseDouble(std::string_view text, std::chars_format format)
+    {
+        double value = 0;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value, format);
+
+        // from_chars leaves value alone when it does not fit, strtod gives +-HUGE_VAL or 0 like lua does for 1e309
+        if (result.ec == std::errc::result_out_of_range)
+        {
+            auto copy = std::string(format == std::chars_format::hex ? "0x" : "");
+            copy += text;
+            value = std::strtod(copy.c_str(), nullptr);
+        }
+
+        return value;
+    }
+
+    // out of range values saturate, casting them would be undefined
+    NumberValue MakeValue(NumberValue::Suffix suffix, double number)
+    {
+        NumberValue value;
+        value.suffix = suffix;
+
+        // 2^63 and 2^64, the first values past the limits that are exact doubles
+        constexpr double signed_limit = 9223372036854775808.0;
+        constexpr double unsigned_limit = 18446744073709551616.0;
+
+        if (suffix == NumberValue::Suffix::LL)
+        {
+            if (number >= signed_limit)
+                value.integer = std::numeric_limits<int64_t>::max();
+            else if (number < -signed_limit)
+                value.integer = std::numeric_limits<int64_t>::min();
+            else
+                value.integer = static_cast<int64_t>(number);
+        }
+        else if (suffix == NumberValue::Suffix::ULL || suffix == NumberValue::Suffix::UL)
+        {
+            if (number >= unsigned_limit)
+                value.unsigned_integer = std::numeric_limits<uint64_t>::max();
+            else if (number <= 0)
+                value.unsigned_integer = 0;
+            else
+                value.unsigned_integer = static_cast<uint64_t>(number);
+        }
+        else
+        {
+            value.number = number;
+        }
+
+        return value;
+    }
+
+    // integer literals keep all 64 bits when they have an integer suffix, like luajit's 0xffffffffffffffffULL
+    NumberValue MakeValue(NumberValue::Suffix suffix, uint64_t integer)
+    {
+        NumberValue value;
+        value.suffix = suffix;
+
+        if (suffix == NumberValue::Suffix::LL)
+            value.integer = static_cast<int64_t>(integer);
+        else if (suffix == NumberValue::Suffix::ULL || suffix == NumberValue::Suffix::UL)
+            value.unsigned_integer = integer;
+        else
+            value.number = static_cast<double>(integer);
+
+        return value;
+    }
+
+    // returns false if the digits do not fit in 64 bits
+    bool ParseInteger(std::string_view digits, int base, uint64_t &integer)
+    {
+        auto result = std::from_chars(digits.data(), digits.data() + digits.size(), integer, base);
+        return result.ec == std::errc() && result.ptr == digits.data() + digits.size();
+    }
+}
+
+NumberValue NumberLiteral::DecodeDecimal(std::string_view text)
+{
+    auto suffix = StripSuffix(text);
+    auto digits = Digits(text);
+
+    uint64_t integer = 0;
+
+    if (digits.view.find_first_of(".eE") == std::string_view::npos && ParseInteger(digits.view, 10, integer))
+        return MakeValue(suffix, integer);
+
+    // libstdc++ uses the eisel-lemire algorithm here
+    return MakeValue(suffix, ParseDouble(digits.view, std::chars_format::general));
+}
+
+NumberValue NumberLiteral::DecodeHex(std::string_view text)
+{
+    text.remove_prefix(2);
+
+    auto suffix = StripSuffix(text);
+    auto digits = Digits(text);
+
+    uint64_t integer = 0;
+
+    if (digits.view.find_first_of(".pP") == std::string_view::npos && ParseInteger(digits.view, 16, integer))
+        return MakeValue(suffix, integer);
+
+    // hex floats and integers past 64 bits, rounded to the nearest double
+    return MakeValue(suffix, ParseDouble(digits.view, std::chars_format::hex));
+}
+
+NumberValue NumberLiteral::DecodeBinary(std::string_view text)
+{
+    text.remove_prefix(2);
+
+    auto suffix = StripSuffix(text);
+    auto digits = Digits(text);
+
+    auto exponent_start = digits.view.find_first_of("eE");
+    auto mantissa = digits.view.substr(0, exponent_start);
+
+    uint64_t integer = 0;
+
+    if (exponent_start == std::string_view::npos && ParseInteger(mantissa, 2, integer))
+        return MakeValue(suffix, integer);
+
+    double number = 0;
+
+    for (auto c : mantissa)
+        number = number * 2 + (c - '0');
+
+    if (exponent_start != std::string_view::npos)
+    {
+        // from_chars does not take a leading +
+        auto exponent = digits.view.substr(exponent_start + 1);
+
+        if (exponent.starts_with('+'))
+            exponent.remove_prefix(1);
+
+        number *= std::pow(10.0, ParseDouble(exponent, std::chars_format::general));
+    }
+
+    return MakeValue(suffix, number);
+}
+
+NumberValue NumberLiteral::Decode(std::string_view text)
+{
+    if (text.size() > 1 && text[0] == '0')
+    {
+        if (Lower(text[1]) == 'x')
+            return DecodeHex(text);
+
+        if (Lower(text[1]) == 'b')
+            return DecodeBinary(text);
+    }
+
+    return DecodeDecimal(text);
+}
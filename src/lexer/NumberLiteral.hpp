@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// the value of a number literal, which member is set depends on the suffix
+struct NumberValue
+{
+    enum Suffix : uint8_t
+    {
+        None, // double
+        LL,   // int64_t
+        ULL,  // uint64_t
+        UL,   // uint64_t
+        I,    // double, the imaginary part
+    };
+
+    Suffix suffix = Suffix::None;
+
+    union
+    {
+        double number = 0;
+        int64_t integer;
+        uint64_t unsigned_integer;
+    };
+
+    double ToDouble() const;
+};
+
+// decodes the text of number tokens, which the lexer has already validated
+namespace NumberLiteral
+{
+    // 1, 1.5, .5, 1_000, 1.5e+10, 50ll
+    NumberValue DecodeDecimal(std::string_view text);
+
+    // 0xff, 0xffull, 0x1.8p+4
+    NumberValue DecodeHex(std::string_view text);
+
+    // 0b101, 0b1_0
+    NumberValue DecodeBinary(std::string_view text);
+
+    // picks one of the above from the prefix
+    NumberValue Decode(std::string_view text);
+}
@@ -0,0 +1,369 @@
+#include "./ScanKernels.hpp"
+#include "../syntax/CharacterClasses.hpp"
+#include <bit>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const uint8_t *Data(std::string_view buffer)
+    {
+        return reinterpret_cast<const uint8_t *>(buffer.data());
+    }
+
+    size_t SkipSpaceScalar(std::string_view buffer, size_t from)
+    {
+        auto data = Data(buffer);
+
+        while (from < buffer.size() && IsSpace(data[from]))
+            from++;
+
+        return from;
+    }
+
+    size_t SkipDuringLetterScalar(std::string_view buffer, size_t from)
+    {
+        auto data = Data(buffer);
+
+        while (from < buffer.size() && IsDuringLetter(data[from]))
+            from++;
+
+        return from;
+    }
+
+    size_t FindNewlineScalar(std::string_view buffer, size_t from)
+    {
+        if (from >= buffer.size())
+            return buffer.size();
+
+        auto found = std::memchr(buffer.data() + from, '\n', buffer.size() - from);
+
+        if (!found)
+            return buffer.size();
+
+        return static_cast<const char *>(found) - buffer.data();
+    }
+
+    size_t FindQuotedStringEndScalar(std::string_view buffer, size_t from, uint8_t quote)
+    {
+        auto data = Data(buffer);
+
+        while (from < buffer.size() && data[from] != quote && data[from] != '\\' && data[from] != '\n')
+            from++;
+
+        return from;
+    }
+
+#ifdef SCAN_KERNELS_X86
+
+    // lo <= v <= hi, unsigned
+    inline __m128i InRange128(__m128i v, uint8_t lo, uint8_t hi)
+    {
+        auto distance = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+        auto limit = _mm_set1_epi8(hi - lo);
+        return _mm_cmpeq_epi8(_mm_max_epu8(distance, limit), limit);
+    }
+
+    inline __m128i IsSpace128(__m128i v)
+    {
+        return InRange128(v, 1, 32);
+    }
+
+    inline __m128i IsDuringLetter128(__m128i v)
+    {
+        auto letter = InRange128(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+        auto number = InRange128(v, '0', '9');
+        auto extra = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('@')));
+        auto high = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(127)), v);
+        return _mm_or_si128(_mm_or_si128(letter, number), _mm_or_si128(extra, high));
+    }
+
+    inline __m128i IsQuotedStringEnd128(__m128i v, uint8_t quote)
+    {
+        auto end = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(quote)), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+        return _mm_or_si128(end, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    }
+
+    inline __m128i Load128(const uint8_t *data)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    }
+
+    size_t SkipSpaceSSE2(std::string_view buffer, size_t from)
+    {
+        auto data = Data(buffer);
+
+        for (; from + 16 <= buffer.size(); from += 16)
+        {
+            uint32_t stops = ~_mm_movemask_epi8(IsSpace128(Load128(data + from))) & 0xFFFF;
+
+            if (stops)
+                return from + std::countr_zero(stops);
+        }
+
+        return SkipSpaceScalar(buffer, from);
+    }
+
+    size_t SkipDuringLetterSSE2(std::string_view buffer, size_t from)
+    {
+        auto data = Data(buffer);
+
+        for (; from + 16 <= buffer.size(); from += 16)
+        {
+            uint32_t stops = ~_mm_movemask_epi8(IsDuringLetter128(Load128(data + from))) & 0xFFFF;
+
+            if (stops)
+                return from + std::countr_zero(stops);
+        }
+
+        return SkipDuringLetterScalar(buffer, from);
+    }
+
+    size_t FindNewlineSSE2(std::string_view buffer, size_t from)
+    {
+        auto data = Data(buffer);
+
+        for (; from + 16 <= buffer.size(); from += 16)
+        {
+            uint32_t stops = _mm_movemask_epi8(_mm_cmpeq_epi8(Load128(data + from), _mm_set1_epi8('\n')));
+
+            if (stops)
+                return from + std::countr_zero(stops);
+        }
+
+        return FindNewlineScalar(buffer, from);
+    }
+
+    size_t FindQuotedStringEndSSE2(std::string_view buffer, size_t from, uint8_t quote)
+    {
+        auto data = Data(buffer);
+
+        for (; from + 16 <= buffer.size(); from += 16)
+        {
+            uint32_t stops = _mm_movemask_epi8(IsQuotedStringEnd128(Load128(data + from), quote));
+
+            if (stops)
+                return from + std::countr_zero(stops);
+        }
+
+        return FindQuotedStringEndScalar(buffer, from, quote);
+    }
+
+#define AVX2 __attribute__((target("avx2")))
+
+    AVX2 inline __m256i InRange256(__m256i v, uint8_t lo, uint8_t hi)
+    {
+        auto distance = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+        auto limit = _mm256_set1_epi8(hi - lo);
+        return _mm256_cmpeq_epi8(_mm256_max_epu8(distance, limit), limit);
+    }
+
+    AVX2 inline __m256i IsSpace256(__m256i v)
+    {
+        return InRange256(v, 1, 32);
+    }
+
+    AVX2 inline __m256i IsDuringLetter256(__m256i v)
+    {
+        auto letter = InRange256(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+        auto number = InRange256(v, '0', '9');
+        auto extra = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('@')));
+        auto high = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(127)), v);
+        return _mm256_or_si256(_mm256_or_si256(letter, number), _mm256_or_si256(extra, high));
+    }
+
+    AVX2 inline __m256i IsQuotedStringEnd256(__m256i v, uint8_t quote)
+    {
+        auto end = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(quote)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+        return _mm256_or_si256(end, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    }
+
+    AVX2 inline __m256i Load256(const uint8_t *data)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+    }
+
+    AVX2 size_t SkipSpaceAVX2(std::string_view buffer, size_t from)
+    {
+        auto data = Data(buffer);
+
+        for (; from + 32 <= buffer.size(); from += 32)
+        {
+            uint32_t stops = ~_mm256_movemask_epi8(IsSpace256(Load256(data + from)));
+
+            if (stops)
+                return from + std::countr_zero(stops);
+        }
+
+        return SkipSpaceSSE2(buffer, from);
+    }
+
+    AVX2 size_t SkipDuringLetterAVX2(std::string_view buffer, size_t from)
+    {
+        auto data = Data(buffer);
+
+        for (; from + 32 <= buffer.size(); from += 32)
+        {
+            uint32_t stops = ~_mm256_movemask_epi8(IsDuringLetter256(Load256(data + from)));
+
+            if (stops)
+                return from + std::countr_zero(stops);
+        }
+
+        return SkipDuringLetterSSE2(buffer, from);
+    }
+
+    AVX2 size_t FindNewlineAVX2(std::string_view buffer, size_t from)
+    {
+        auto data = Data(buffer);
+
+        for (; from + 32 <= buffer.size(); from += 32)
+        {
+            uint32_t stops = _mm256_movemask_epi8(_mm256_cmpeq_epi8(Load256(data + from), _mm256_set1_epi8('\n')));
+
+            if (stops)
+                return from + std::countr_zero(stops);
+        }
+
+        return FindNewlineSSE2(buffer, from);
+    }
+
+    AVX2 size_t FindQuotedStringEndAVX2(std::string_view buffer, size_t from, uint8_t quote)
+    {
+        auto data = Data(buffer);
+
+        for (; from + 32 <= buffer.size(); from += 32)
+        {
+            uint32_t stops = _mm256_movemask_epi8(IsQuotedStringEnd256(Load256(data + from), quote));
+
+            if (stops)
+                return from + std::countr_zero(stops);
+        }
+
+        return FindQuotedStringEndSSE2(buffer, from, quote);
+    }
+
+#undef AVX2
+
+#endif
+
+    struct Kernels
+    {
+        ScanKernels::Implementation implementation;
+        const char *name;
+        size_t (*skip_space)(std::string_view, size_t);
+        size_t (*skip_during_letter)(std::string_view, size_t);
+        size_t (*find_newline)(std::string_view, size_t);
+        size_t (*find_quoted_string_end)(std::string_view, size_t, uint8_t);
+    };
+
+    const Kernels scalar_kernels = {ScanKernels::Implementation::Scalar, "scalar", SkipSpaceScalar, SkipDuringLetterScalar, FindNewlineScalar, FindQuotedStringEndScalar};
+
+#ifdef SCAN_KERNELS_X86
+    const Kernels sse2_kernels = {ScanKernels::Implementation::SSE2, "sse2", SkipSpaceSSE2, SkipDuringLetterSSE2, FindNewlineSSE2, FindQuotedStringEndSSE2};
+    const Kernels avx2_kernels = {ScanKernels::Implementation::AVX2, "avx2", SkipSpaceAVX2, SkipDuringLetterAVX2, FindNewlineAVX2, FindQuotedStringEndAVX2};
+#endif
+
+    const Kernels *GetKernels(ScanKernels::Implementation implementation)
+    {
+        switch (implementation)
+        {
+        case ScanKernels::Implementation::Scalar:
+            return &scalar_kernels;
+#ifdef SCAN_KERNELS_X86
+        case ScanKernels::Implementation::SSE2:
+            return &sse2_kernels;
+        case ScanKernels::Implementation::AVX2:
+            return __builtin_cpu_supports("avx2") ? &avx2_kernels : nullptr;
+#endif
+        default:
+            return nullptr;
+        }
+    }
+
+    const Kernels *SelectKernels()
+    {
+        if (auto kernels = GetKernels(ScanKernels::Implementation::AVX2))
+            return kernels;
+
+        if (auto kernels = GetKernels(ScanKernels::Implementation::SSE2))
+            return kernels;
+
+        return &scalar_kernels;
+    }
+
+    const Kernels *kernels = SelectKernels();
+}
+
+ScanKernels::Implementation ScanKernels::GetImplementation()
+{
+    return kernels->implementation;
+}
+
+const char *ScanKernels::GetImplementationName()
+{
+    return kernels->name;
+}
+
+bool ScanKernels::SetImplementation(Implementation implementation)
+{
+    auto selected = GetKernels(implementation);
+
+    if (!selected)
+        return false;
+
+    kernels = selected;
+    return true;
+}
+
+size_t ScanKernels::SkipSpace(std::string_view buffer, size_t from)
+{
+    return kernels->skip_space(buffer, from);
+}
+
+size_t ScanKernels::SkipDuringLetter(std::string_view buffer, size_t from)
+{
+    return kernels->skip_during_letter(buffer, from);
+}
+
+size_t ScanKernels::FindNewline(std::string_view buffer, size_t from)
+{
+    return kernels->find_newline(buffer, from);
+}
+
+size_t ScanKernels::FindQuotedStringEnd(std::string_view buffer, size_t from, uint8_t quote)
+{
+    return kernels->find_quoted_string_end(buffer, from, quote);
+}
+
+size_t ScanKernels::FindClosingLongBracket(std::string_view buffer, size_t from, size_t level)
+{
+    auto data = Data(buffer);
+    auto size = buffer.size();
+
+    while (from < size)
+    {
+        auto found = std::memchr(data + from, ']', size - from);
+
+        if (!found)
+            break;
+
+        auto close = static_cast<size_t>(static_cast<const uint8_t *>(found) - data);
+        auto i = close + 1;
+
+        while (i < size && data[i] == '=')
+            i++;
+
+        if (i < size && data[i] == ']' && i - close - 1 == level)
+            return close;
+
+        // data[i] is not =, so it may start the next candidate
+        from = i;
+    }
+
+    return size;
+}
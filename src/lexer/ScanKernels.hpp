@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// scanners for the long runs in lua code: whitespace, identifiers, comments and quoted strings
+// each one returns the index of the first byte at or after from that ends the run, or buffer.size()
+// the implementation is picked at startup from what the cpu supports
+namespace ScanKernels
+{
+    enum class Implementation
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+    };
+
+    Implementation GetImplementation();
+    const char *GetImplementationName();
+
+    // returns false if the cpu does not support the implementation
+    // not thread safe, meant for tests and benchmarks
+    bool SetImplementation(Implementation implementation);
+
+    // first byte that is not a space
+    size_t SkipSpace(std::string_view buffer, size_t from);
+
+    // first byte that cannot be part of an identifier
+    size_t SkipDuringLetter(std::string_view buffer, size_t from);
+
+    // first \n
+    size_t FindNewline(std::string_view buffer, size_t from);
+
+    // first quote, backslash or \n
+    size_t FindQuotedStringEnd(std::string_view buffer, size_t from, uint8_t quote);
+
+    // start of the first ]=*] with exactly level =, never looks at a byte more than twice
+    size_t FindClosingLongBracket(std::string_view buffer, size_t from, size_t level);
+}
@@ -0,0 +1,246 @@
+#include "./StringLiteral.hpp"
+#include "../syntax/CharacterClasses.hpp"
+
+std::string_view StringLiteral::GetBody(std::string_view literal)
+{
+    if (literal.size() < 2)
+        return {};
+
+    if (literal[0] != '[')
+        return literal.substr(1, literal.size() - 2);
+
+    // [==[ body ]==]
+    size_t level = 0;
+
+    while (level + 1 < literal.size() && literal[level + 1] == '=')
+        level++;
+
+    auto bracket = level + 2;
+
+    if (literal.size() < bracket * 2)
+        return {};
+
+    auto body = literal.substr(bracket, literal.size() - bracket * 2);
+
+    if (body.starts_with("\r\n") || body.starts_with("\n\r"))
+        body.remove_prefix(2);
+    else if (body.starts_with('\n') || body.starts_with('\r'))
+        body.remove_prefix(1);
+
+    return body;
+}
+
+bool StringLiteral::HasEscapes(std::string_view literal)
+{
+    return !literal.starts_with('[') && literal.find('\\') != std::string_view::npos;
+}
+
+static uint8_t HexValue(uint8_t c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+
+    return (c | 0x20) - 'a' + 10;
+}
+
+// lua 5.4 allows code points below 2^31 with the old 6 byte utf-8 forms
+static constexpr uint32_t MAX_CODE_POINT = 0x7FFFFFFF;
+
+size_t StringLiteral::ReadUtf8Escape(std::string_view text, uint32_t &code_point)
+{
+    if (text.empty() || text[0] != '{')
+        return 0;
+
+    code_point = 0;
+    size_t i = 1;
+
+    for (; i < text.size() && IsValidHex(text[i]); i++)
+    {
+        if (code_point > MAX_CODE_POINT >> 4)
+            return 0;
+
+        code_point = code_point << 4 | HexValue(text[i]);
+    }
+
+    if (i == 1 || i >= text.size() || text[i] != '}')
+        return 0;
+
+    return i + 1;
+}
+
+// code_point is at most MAX_CODE_POINT, which needs 6 bytes
+static size_t EncodeUtf8(uint32_t code_point, char *out)
+{
+    if (code_point < 0x80)
+    {
+        out[0] = static_cast<char>(code_point);
+        return 1;
+    }
+
+    // fill continuation bytes from the back until the rest fits in the first byte
+    char buffer[6];
+    size_t length = 0;
+    uint32_t first_byte_limit = 0x3f;
+
+    while (code_point > first_byte_limit)
+    {
+        buffer[5 - length++] = static_cast<char>(0x80 | (code_point & 0x3f));
+        code_point >>= 6;
+        first_byte_limit >>= 1;
+    }
+
+    buffer[5 - length] = static_cast<char>((~first_byte_limit << 1) | code_point);
+    length++;
+
+    for (size_t i = 0; i < length; i++)
+        out[i] = buffer[6 - length + i];
+
+    return length;
+}
+
+size_t StringLiteral::Unescape(std::string_view body, char *out)
+{
+    size_t length = 0;
+    size_t i = 0;
+
+    while (i < body.size())
+    {
+        auto escape = body.find('\\', i);
+
+        if (escape == std::string_view::npos)
+            escape = body.size();
+
+        for (; i < escape; i++)
+            out[length++] = body[i];
+
+        // a trailing backslash can only come from a malformed literal
+        if (i + 1 >= body.size())
+            break;
+
+        auto c = static_cast<uint8_t>(body[i + 1]);
+        i += 2;
+
+        switch (c)
+        {
+        case 'a':
+            out[length++] = '\a';
+            break;
+        case 'b':
+            out[length++] = '\b';
+            break;
+        case 'f':
+            out[length++] = '\f';
+            break;
+        case 'n':
+            out[length++] = '\n';
+            break;
+        case 'r':
+            out[length++] = '\r';
+            break;
+        case 't':
+            out[length++] = '\t';
+            break;
+        case 'v':
+            out[length++] = '\v';
+            break;
+        case '\n':
+        case '\r':
+            // \ followed by a line break is a newline, \r\n and \n\r count as one
+            out[length++] = '\n';
+
+            if (i < body.size() && (body[i] == '\n' || body[i] == '\r') && body[i] != c)
+                i++;
+            break;
+        case 'z':
+            while (i < body.size() && IsSpace(body[i]))
+                i++;
+            break;
+        case 'x':
+            if (i + 1 < body.size() && IsValidHex(body[i]) && IsValidHex(body[i + 1]))
+            {
+                out[length++] = static_cast<char>(HexValue(body[i]) << 4 | HexValue(body[i + 1]));
+                i += 2;
+            }
+            else
+            {
+                out[length++] = 'x';
+            }
+            break;
+        case 'u':
+        {
+            uint32_t code_point;
+
+            if (auto escape_length = ReadUtf8Escape(body.substr(i), code_point))
+            {
+                length += EncodeUtf8(code_point, out + length);
+                i += escape_length;
+            }
+            else
+            {
+                out[length++] = 'u';
+            }
+            break;
+        }
+        default:
+            if (IsNumber(c))
+            {
+                // up to three decimal digits
+                uint32_t value = c - '0';
+
+                for (int digits = 1; digits < 3 && i < body.size() && IsNumber(body[i]); digits++)
+                    value = value * 10 + (body[i++] - '0');
+
+                out[length++] = static_cast<char>(value);
+            }
+            else
+            {
+                // \\ \" \' and anything lua would reject
+                out[length++] = static_cast<char>(c);
+            }
+            break;
+        }
+    }
+
+    return length;
+}
+
+char *StringLiteralCache::Allocate(size_t size)
+{
+    // large values get a block of their own so the current block keeps filling up
+    if (size > BLOCK_SIZE / 4)
+    {
+        blocks.push_back(std::make_unique<char[]>(size));
+        arena_size += size;
+        return blocks.back().get();
+    }
+
+    if (!block || block_used + size > BLOCK_SIZE)
+    {
+        blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+        block = blocks.back().get();
+        block_used = 0;
+        arena_size += BLOCK_SIZE;
+    }
+
+    auto memory = block + block_used;
+    block_used += size;
+
+    return memory;
+}
+
+std::string_view StringLiteralCache::Get(uint32_t index, std::string_view literal)
+{
+    if (!StringLiteral::HasEscapes(literal))
+        return StringLiteral::GetBody(literal);
+
+    if (auto found = unescaped.find(index); found != unescaped.end())
+        return found->second;
+
+    auto body = StringLiteral::GetBody(literal);
+    auto memory = Allocate(body.size());
+    auto value = std::string_view(memory, StringLiteral::Unescape(body, memory));
+
+    unescaped.emplace(index, value);
+
+    return value;
+}
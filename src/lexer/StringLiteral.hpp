@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "./TokenBuffer.hpp"
+
+// the values of string tokens, which the lexer has already validated
+namespace StringLiteral
+{
+    // the text between the quotes or long brackets
+    // a long string drops the newline right after its opening bracket, like lua does
+    std::string_view GetBody(std::string_view literal);
+
+    // long strings never have escapes
+    bool HasEscapes(std::string_view literal);
+
+    // reads the {XXX} of a \u{XXX} escape at the start of text into code_point and returns its length with the braces
+    // 0 when there is no closing brace, no digits, something other than hex digits or a value above 0x7FFFFFFF
+    size_t ReadUtf8Escape(std::string_view text, uint32_t &code_point);
+
+    // writes the unescaped body to out and returns its length, which is never longer than body
+    // \a \b \f \n \r \t \v \\ \" \' \<newline> \z \xXX \ddd \u{XXX}
+    size_t Unescape(std::string_view body, char *out);
+}
+
+// hands out string values by token index, unescaping each literal at most once
+// values without escapes point into the code, the others into the cache
+class StringLiteralCache
+{
+public:
+    std::string_view Get(uint32_t index, std::string_view literal);
+    std::string_view Get(const TokenBuffer &buffer, size_t index) { return Get(index, buffer.GetValue(index)); }
+
+    // bytes held for unescaped values
+    size_t GetArenaSize() const { return arena_size; }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    std::unordered_map<uint32_t, std::string_view> unescaped;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *block = nullptr;
+    size_t block_used = 0;
+    size_t arena_size = 0;
+
+    char *Allocate(size_t size);
+};
@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <optional>
+#include "./NumberLiteral.hpp"
+#include "../syntax/Atom.hpp"
 
 class Token
 {
@@ -19,6 +22,7 @@ public:
         EndOfFile, // sort of whitespace
         Shebang,   // sort of whitespace
         Unknown,
+        Error,
 
         LineComment,
         MultilineComment,
@@ -30,7 +34,14 @@ public:
     size_t start;
     size_t stop;
     std::string_view value;
+    // position in the token stream, whitespace tokens are not counted
+    uint32_t index = 0;
+    // set for Letter and Symbol tokens
+    Atom::Id atom = Atom::None;
+    // set for Number tokens when the lexer decodes numbers
+    std::optional<NumberValue> number;
     std::vector<std::unique_ptr<Token>> whitespace;
+    Token(Token &&) = default;
     Token &operator=(Token &&) = default;
     inline Token(Token::Kind kind)
     {
@@ -39,11 +50,15 @@ public:
     ~Token()
     {
     }
-    inline bool IsWhitespace()
+    static inline bool IsWhitespace(Token::Kind kind)
     {
         return kind == Token::Kind::Space ||
                kind == Token::Kind::LineComment ||
                kind == Token::Kind::MultilineComment ||
                kind == Token::Kind::CommentEscape;
     }
+    inline bool IsWhitespace()
+    {
+        return IsWhitespace(kind);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "./TokenBuffer.hpp"
+#include <algorithm>
+
+TokenBuffer::TokenBuffer(std::shared_ptr<Code> code)
+{
+    this->code = code;
+}
+
+void TokenBuffer::Reserve(size_t count)
+{
+    kinds.reserve(count);
+    starts.reserve(count);
+    lengths.reserve(count);
+    states.reserve(count);
+    atoms.reserve(count);
+    whitespace_offsets.reserve(count + 1);
+}
+
+void TokenBuffer::Clear(std::shared_ptr<Code> code)
+{
+    this->code = code;
+    kinds.clear();
+    starts.clear();
+    lengths.clear();
+    states.clear();
+    atoms.clear();
+    whitespace_offsets.clear();
+    whitespace_offsets.push_back(0);
+    whitespace_kinds.clear();
+    whitespace_starts.clear();
+    whitespace_lengths.clear();
+    numbers.clear();
+    diagnostics.clear();
+}
+
+void TokenBuffer::Add(Token::Kind kind, size_t start, size_t stop, State state, Atom::Id atom)
+{
+    kinds.push_back(kind);
+    starts.push_back(static_cast<uint32_t>(start));
+    lengths.push_back(static_cast<uint32_t>(stop - start));
+    states.push_back(state);
+    atoms.push_back(atom);
+    whitespace_offsets.push_back(static_cast<uint32_t>(whitespace_kinds.size()));
+}
+
+void TokenBuffer::AddWhitespace(Token::Kind kind, size_t start, size_t stop)
+{
+    whitespace_kinds.push_back(kind);
+    whitespace_starts.push_back(static_cast<uint32_t>(start));
+    whitespace_lengths.push_back(static_cast<uint32_t>(stop - start));
+}
+
+static bool IsBefore(const TokenBuffer::Number &number, size_t index)
+{
+    return number.token < index;
+}
+
+void TokenBuffer::Append(const TokenBuffer &other, size_t from, size_t to)
+{
+    if (from >= to)
+        return;
+
+    auto number_from = std::lower_bound(other.numbers.begin(), other.numbers.end(), from, IsBefore);
+    auto number_to = std::lower_bound(number_from, other.numbers.end(), to, IsBefore);
+
+    for (auto number = number_from; number != number_to; number++)
+        numbers.push_back(Number{.token = static_cast<uint32_t>(number->token - from + Size()), .value = number->value});
+
+    kinds.insert(kinds.end(), other.kinds.begin() + from, other.kinds.begin() + to);
+    starts.insert(starts.end(), other.starts.begin() + from, other.starts.begin() + to);
+    lengths.insert(lengths.end(), other.lengths.begin() + from, other.lengths.begin() + to);
+    states.insert(states.end(), other.states.begin() + from, other.states.begin() + to);
+    atoms.insert(atoms.end(), other.atoms.begin() + from, other.atoms.begin() + to);
+
+    auto whitespace_from = other.whitespace_offsets[from];
+    auto whitespace_to = other.whitespace_offsets[to];
+    auto whitespace_shift = whitespace_kinds.size() - whitespace_from;
+
+    for (auto i = from + 1; i <= to; i++)
+        whitespace_offsets.push_back(static_cast<uint32_t>(other.whitespace_offsets[i] + whitespace_shift));
+
+    whitespace_kinds.insert(whitespace_kinds.end(), other.whitespace_kinds.begin() + whitespace_from, other.whitespace_kinds.begin() + whitespace_to);
+    whitespace_starts.insert(whitespace_starts.end(), other.whitespace_starts.begin() + whitespace_from, other.whitespace_starts.begin() + whitespace_to);
+    whitespace_lengths.insert(whitespace_lengths.end(), other.whitespace_lengths.begin() + whitespace_from, other.whitespace_lengths.begin() + whitespace_to);
+}
+
+template <typename T>
+static void Replace(std::vector<T> &target, size_t from, size_t to, const std::vector<T> &source, size_t source_from, size_t source_to)
+{
+    auto common = std::min(to - from, source_to - source_from);
+    std::copy(source.begin() + source_from, source.begin() + source_from + common, target.begin() + from);
+
+    if (to - from > common)
+        target.erase(target.begin() + from + common, target.begin() + to);
+    else
+        target.insert(target.begin() + from + common, source.begin() + source_from + common, source.begin() + source_to);
+}
+
+void TokenBuffer::Splice(size_t from, size_t to, const TokenBuffer &replacement, ptrdiff_t shift)
+{
+    auto whitespace_from = whitespace_offsets[from];
+    auto whitespace_to = whitespace_offsets[to];
+    auto whitespace_count = replacement.whitespace_kinds.size();
+
+    Replace(whitespace_kinds, whitespace_from, whitespace_to, replacement.whitespace_kinds, 0, whitespace_count);
+    Replace(whitespace_starts, whitespace_from, whitespace_to, replacement.whitespace_starts, 0, whitespace_count);
+    Replace(whitespace_lengths, whitespace_from, whitespace_to, replacement.whitespace_lengths, 0, whitespace_count);
+
+    for (auto i = whitespace_from + whitespace_count; i < whitespace_starts.size(); i++)
+        whitespace_starts[i] += shift;
+
+    Replace(kinds, from, to, replacement.kinds, 0, replacement.Size());
+    Replace(starts, from, to, replacement.starts, 0, replacement.Size());
+    Replace(lengths, from, to, replacement.lengths, 0, replacement.Size());
+    Replace(states, from, to, replacement.states, 0, replacement.Size());
+    Replace(atoms, from, to, replacement.atoms, 0, replacement.Size());
+
+    for (auto i = from + replacement.Size(); i < starts.size(); i++)
+        starts[i] += shift;
+
+    auto number_from = std::lower_bound(numbers.begin(), numbers.end(), from, IsBefore);
+    auto number_to = std::lower_bound(number_from, numbers.end(), to, IsBefore);
+    auto token_shift = static_cast<ptrdiff_t>(replacement.Size()) - static_cast<ptrdiff_t>(to - from);
+
+    for (auto number = number_to; number != numbers.end(); number++)
+        number->token += token_shift;
+
+    auto replacement_numbers = replacement.numbers;
+
+    for (auto &number : replacement_numbers)
+        number.token += from;
+
+    Replace(numbers, number_from - numbers.begin(), number_to - numbers.begin(), replacement_numbers, 0, replacement_numbers.size());
+
+    // offsets [from + 1, to] belong to the replaced tokens, the ones after move by the change in whitespace count
+    Replace(whitespace_offsets, from + 1, to + 1, replacement.whitespace_offsets, 1, replacement.Size() + 1);
+
+    for (auto i = from + 1; i <= from + replacement.Size(); i++)
+        whitespace_offsets[i] += whitespace_from;
+
+    auto whitespace_shift = static_cast<ptrdiff_t>(whitespace_count) - static_cast<ptrdiff_t>(whitespace_to - whitespace_from);
+
+    for (auto i = from + replacement.Size() + 1; i < whitespace_offsets.size(); i++)
+        whitespace_offsets[i] += whitespace_shift;
+}
+
+void TokenBuffer::AddNumber(NumberValue value)
+{
+    numbers.push_back(Number{.token = static_cast<uint32_t>(Size() - 1), .value = value});
+}
+
+const NumberValue *TokenBuffer::GetNumber(size_t index) const
+{
+    auto found = std::lower_bound(numbers.begin(), numbers.end(), index, IsBefore);
+
+    if (found == numbers.end() || found->token != index)
+        return nullptr;
+
+    return &found->value;
+}
+
+std::string_view TokenBuffer::GetValue(size_t index) const
+{
+    return code->GetStringSlice(GetStart(index), GetStop(index));
+}
+
+size_t TokenBuffer::GetWhitespaceCount(size_t index) const
+{
+    return whitespace_offsets[index + 1] - whitespace_offsets[index];
+}
+
+size_t TokenBuffer::GetMemoryUsage() const
+{
+    return kinds.capacity() * sizeof(Token::Kind) +
+           starts.capacity() * sizeof(uint32_t) +
+           lengths.capacity() * sizeof(uint32_t) +
+           states.capacity() * sizeof(State) +
+           atoms.capacity() * sizeof(Atom::Id) +
+           numbers.capacity() * sizeof(Number) +
+           whitespace_offsets.capacity() * sizeof(uint32_t) +
+           whitespace_kinds.capacity() * sizeof(Token::Kind) +
+           whitespace_starts.capacity() * sizeof(uint32_t) +
+           whitespace_lengths.capacity() * sizeof(uint32_t);
+}
+
+Token TokenBuffer::MakeToken(size_t index) const
+{
+    auto token = Token(GetKind(index));
+    token.start = GetStart(index);
+    token.stop = GetStop(index);
+    token.value = GetValue(index);
+    token.atom = GetAtom(index);
+    token.index = static_cast<uint32_t>(index);
+
+    if (auto number = GetNumber(index))
+        token.number = *number;
+
+    for (auto i = whitespace_offsets[index]; i < whitespace_offsets[index + 1]; i++)
+    {
+        auto whitespace_token = std::make_unique<Token>(whitespace_kinds[i]);
+        whitespace_token->start = whitespace_starts[i];
+        whitespace_token->stop = whitespace_starts[i] + whitespace_lengths[i];
+        whitespace_token->value = code->GetStringSlice(whitespace_token->start, whitespace_token->stop);
+        token.whitespace.push_back(std::move(whitespace_token));
+    }
+
+    return token;
+}
+
+std::unique_ptr<Token> TokenBuffer::ToToken(size_t index) const
+{
+    return std::make_unique<Token>(MakeToken(index));
+}
+
+std::vector<std::unique_ptr<Token>> TokenBuffer::ToTokens() const
+{
+    auto tokens = std::vector<std::unique_ptr<Token>>();
+    tokens.reserve(Size());
+
+    for (size_t i = 0; i < Size(); i++)
+    {
+        tokens.push_back(ToToken(i));
+    }
+
+    return tokens;
+}
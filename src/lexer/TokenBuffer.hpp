@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "../code/Code.hpp"
+#include "./LexerDiagnostic.hpp"
+#include "./Token.hpp"
+
+// compact token stream, one entry per token in each array
+// tokens are addressed by their index instead of by pointer
+class TokenBuffer
+{
+public:
+    static constexpr size_t MAX_CODE_SIZE = std::numeric_limits<uint32_t>::max();
+
+    // lexer state at the start of the whitespace preceding a token, lexing can resume from any token with it
+    enum State : uint8_t
+    {
+        Normal,
+        InCommentEscape,
+    };
+
+    std::shared_ptr<Code> code;
+
+    std::vector<Token::Kind> kinds;
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> lengths;
+    std::vector<State> states;
+    std::vector<Atom::Id> atoms;
+
+    // the whitespace preceding token i is whitespace_*[whitespace_offsets[i]] to whitespace_*[whitespace_offsets[i + 1]]
+    std::vector<uint32_t> whitespace_offsets = {0};
+    std::vector<Token::Kind> whitespace_kinds;
+    std::vector<uint32_t> whitespace_starts;
+    std::vector<uint32_t> whitespace_lengths;
+
+    struct Number
+    {
+        uint32_t token;
+        NumberValue value;
+    };
+
+    // decoded number literals, sorted by token index
+    std::vector<Number> numbers;
+
+    std::vector<LexerDiagnostic> diagnostics;
+
+    explicit TokenBuffer(std::shared_ptr<Code> code);
+
+    void Reserve(size_t count);
+    // empties the buffer for other code, keeping the capacity of every column
+    void Clear(std::shared_ptr<Code> code);
+    void Add(Token::Kind kind, size_t start, size_t stop, State state = State::Normal, Atom::Id atom = Atom::None);
+    void AddWhitespace(Token::Kind kind, size_t start, size_t stop);
+    // the value of the last added token
+    void AddNumber(NumberValue value);
+    // appends tokens [from, to) of other with their whitespace
+    void Append(const TokenBuffer &other, size_t from, size_t to);
+    // replaces tokens [from, to) and their whitespace with all of replacement, tokens after to move by shift
+    void Splice(size_t from, size_t to, const TokenBuffer &replacement, ptrdiff_t shift);
+
+    inline size_t Size() const { return kinds.size(); }
+    inline Token::Kind GetKind(size_t index) const { return kinds[index]; }
+    inline size_t GetStart(size_t index) const { return starts[index]; }
+    inline size_t GetStop(size_t index) const { return starts[index] + lengths[index]; }
+    inline State GetState(size_t index) const { return states[index]; }
+    inline Atom::Id GetAtom(size_t index) const { return atoms[index]; }
+    // where the whitespace preceding the token starts
+    inline size_t GetBoundary(size_t index) const { return index == 0 ? 0 : GetStop(index - 1); }
+    std::string_view GetValue(size_t index) const;
+    // nullptr unless the token is a decoded number
+    const NumberValue *GetNumber(size_t index) const;
+    size_t GetWhitespaceCount(size_t index) const;
+
+    size_t GetMemoryUsage() const;
+
+    Token MakeToken(size_t index) const;
+    // materializes the buffer as heap allocated tokens for code that consumes std::vector<std::unique_ptr<Token>>
+    std::unique_ptr<Token> ToToken(size_t index) const;
+    std::vector<std::unique_ptr<Token>> ToTokens() const;
+};
@@ -0,0 +1,64 @@
+#include "./TriviaReader.hpp"
+
+TriviaReader::TriviaReader(BaseLexer &lexer, const TokenBuffer &buffer, bool use_cache) : buffer(buffer)
+{
+    this->lexer = lexer.Fork();
+    this->lexer->keep_whitespace = true;
+    this->use_cache = use_cache;
+}
+
+void TriviaReader::Read(size_t index, std::vector<Trivia> &out)
+{
+    auto stop = buffer.GetStart(index);
+
+    // the state recorded for a token is the one at the start of its gap
+    lexer->position = buffer.GetBoundary(index);
+    lexer->comment_escape = buffer.GetState(index) == TokenBuffer::State::InCommentEscape;
+
+    while (lexer->position < stop)
+    {
+        auto start = lexer->position;
+        auto kind = lexer->ReadTokenKind();
+
+        if (!Token::IsWhitespace(kind))
+            break;
+
+        out.push_back(Trivia{.kind = kind, .start = static_cast<uint32_t>(start), .stop = static_cast<uint32_t>(lexer->position)});
+    }
+
+    // unterminated comments were already reported when the buffer was lexed
+    lexer->diagnostics.clear();
+}
+
+std::span<const TriviaReader::Trivia> TriviaReader::Get(size_t index)
+{
+    if (!use_cache)
+    {
+        scratch.clear();
+        Read(index, scratch);
+        return scratch;
+    }
+
+    auto [found, inserted] = cache.try_emplace(static_cast<uint32_t>(index));
+
+    if (inserted)
+        Read(index, found->second);
+
+    return found->second;
+}
+
+std::vector<std::unique_ptr<Token>> TriviaReader::GetTokens(size_t index)
+{
+    auto tokens = std::vector<std::unique_ptr<Token>>();
+
+    for (auto &trivia : Get(index))
+    {
+        auto token = std::make_unique<Token>(trivia.kind);
+        token->start = trivia.start;
+        token->stop = trivia.stop;
+        token->value = buffer.code->GetStringSlice(trivia.start, trivia.stop);
+        tokens.push_back(std::move(token));
+    }
+
+    return tokens;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "./BaseLexer.hpp"
+#include "./TokenBuffer.hpp"
+
+// reads the whitespace and comments preceding a token when asked for, by lexing the gap between the previous
+// token and this one again. meant for buffers lexed with keep_whitespace = false
+class TriviaReader
+{
+public:
+    struct Trivia
+    {
+        Token::Kind kind;
+        uint32_t start;
+        uint32_t stop;
+    };
+
+    // reads with a fork of lexer, buffer must have been lexed from the same code
+    // with use_cache each gap is only read once, otherwise the result of Get is valid until the next call
+    TriviaReader(BaseLexer &lexer, const TokenBuffer &buffer, bool use_cache = false);
+
+    std::span<const Trivia> Get(size_t index);
+    // the same tokens Token::whitespace would hold
+    std::vector<std::unique_ptr<Token>> GetTokens(size_t index);
+
+private:
+    std::unique_ptr<BaseLexer> lexer;
+    const TokenBuffer &buffer;
+    bool use_cache;
+    std::vector<Trivia> scratch;
+    std::unordered_map<uint32_t, std::vector<Trivia>> cache;
+
+    void Read(size_t index, std::vector<Trivia> &out);
+};
@@ -1,12 +1,14 @@
 #include "./LuaParser.hpp"
+#include "./PrimaryExpression.hpp"
+#include "./Statement.hpp"
 
 bool LuaParser::IsTokenValue(PeekedToken token)
 {
     if (token->kind == Token::Kind::Number || token->kind == Token::Kind::String)
         return true;
-    if (runtime_syntax->IsKeywordValue(token->value))
+    if (GetSyntax().IsKeywordValue(token->atom))
         return true;
-    if (runtime_syntax->IsKeyword(token->value))
+    if (GetSyntax().IsKeyword(token->atom))
         return false;
     if (token->kind == Token::Kind::Letter)
         return true;
@@ -15,17 +17,17 @@ bool LuaParser::IsTokenValue(PeekedToken token)
 
 LuaParser::TokenType LuaParser::GetTokenType(PeekedToken token)
 {
-    if (token->kind == Token::Kind::Letter && runtime_syntax->IsKeyword(token->value))
+    if (token->kind == Token::Kind::Letter && GetSyntax().IsKeyword(token->atom))
     {
         return TokenType::Keyword;
     }
     else if (token->kind == Token::Kind::Symbol)
     {
-        if (runtime_syntax->IsPrefixOperator(token->value))
+        if (GetSyntax().IsPrefixOperator(token->atom))
             return TokenType::PrefixOperator;
-        else if (runtime_syntax->IsPostfixOperator(token->value))
+        else if (GetSyntax().IsPostfixOperator(token->atom))
             return TokenType::PostfixOperator;
-        else if (runtime_syntax->IsBinaryOperator(token->value))
+        else if (GetSyntax().IsBinaryOperator(token->atom))
             return TokenType::BinaryOperator;
     }
     else if (token->kind == Token::Kind::Number)
@@ -40,14 +42,137 @@ LuaParser::TokenType LuaParser::GetTokenType(PeekedToken token)
     return TokenType::None;
 }
 
-LuaParser::LuaParser(std::vector<std::unique_ptr<Token>> tokens)
+static std::shared_ptr<TokenStore> StoreFromVector(std::vector<std::unique_ptr<Token>> tokens)
 {
-    this->tokens = std::move(tokens);
+    auto store = std::make_shared<TokenStore>();
+    store->Reserve(tokens.size() + 1);
+
+    for (auto &token : tokens)
+        store->Add(std::move(*token));
+
+    return store;
+}
+
+static void AddTokens(TokenStore &store, const TokenBuffer &buffer)
+{
+    store.Reserve(buffer.Size() + 1);
+
+    for (size_t i = 0; i < buffer.Size(); i++)
+        store.Add(buffer.MakeToken(i));
+}
+
+static std::shared_ptr<TokenStore> StoreFromBuffer(const TokenBuffer &buffer)
+{
+    auto store = std::make_shared<TokenStore>();
+    AddTokens(*store, buffer);
+
+    return store;
+}
+
+static TokenWindow::Source ReadFromLexer(std::shared_ptr<BaseLexer> lexer)
+{
+    auto iterator = std::make_shared<BaseLexer::TokenIterator>(lexer->begin());
+
+    return [lexer, iterator]() -> std::unique_ptr<Token>
+    {
+        if (*iterator == std::default_sentinel)
+            return nullptr;
+
+        auto token = std::move(**iterator);
+        ++*iterator;
+
+        return token;
+    };
+}
+
+LuaParser::LuaParser() : window(std::make_shared<TokenStore>())
+{
+    storage->tokens = window.GetStore();
+}
+
+LuaParser::LuaParser(std::vector<std::unique_ptr<Token>> tokens) : window(StoreFromVector(std::move(tokens)))
+{
+    storage->tokens = window.GetStore();
+}
+
+LuaParser::LuaParser(const TokenBuffer &buffer) : window(StoreFromBuffer(buffer))
+{
+    storage->tokens = window.GetStore();
+}
+
+LuaParser::LuaParser(std::shared_ptr<BaseLexer> lexer) : window(std::make_shared<TokenStore>(), ReadFromLexer(lexer))
+{
+    storage->tokens = window.GetStore();
+}
+
+ParseResult<Expression> LuaParser::ParseExpression()
+{
+    return Result(ValueExpression::Parse(*this));
+}
+
+ParseResult<Root> LuaParser::ParseFile()
+{
+    auto root = New<Root>();
+    StartNode(root);
+
+    while (auto statement = Statement::ParseTopLevel(*this))
+        root->statements.push_back(GetArena(), statement);
+
+    root->statements.push_back(GetArena(), EndOfFileStatement::Parse(*this));
+    EndNode(root);
+
+    return Result(root);
 }
 
-bool LuaParser::IsValue(std::string_view val, const uint8_t offset)
+void LuaParser::ParseStatements(const std::function<void(ParseResult<Statement>)> &callback)
 {
-    return PeekToken(offset)->value == val;
+    while (auto statement = Statement::ParseTopLevel(*this))
+    {
+        callback(Result(statement));
+
+        // held by this parser alone unless callback kept the statement
+        if (storage.use_count() == 1)
+        {
+            storage->Reset();
+        }
+        else
+        {
+            auto tokens = storage->tokens;
+            storage = std::make_shared<ParseStorage>();
+            storage->tokens = std::move(tokens);
+        }
+    }
+
+    callback(Result<Statement>(EndOfFileStatement::Parse(*this)));
+}
+
+void LuaParser::Reset(const TokenBuffer &buffer)
+{
+    auto store = window.GetStore();
+
+    // held by the window, the storage and the copy above when nothing else refers to them
+    if (storage.use_count() == 1 && store.use_count() == 3)
+    {
+        storage->Reset();
+        store->Clear();
+    }
+    else
+    {
+        storage = std::make_shared<ParseStorage>();
+        store = std::make_shared<TokenStore>();
+        storage->tokens = store;
+    }
+
+    AddTokens(*store, buffer);
+    window = TokenWindow(store);
+    environment = ParserNode::Runtime;
+    expression_stack.clear();
+    block_depth = 0;
+}
+
+bool LuaParser::IsValue(Atom::Id atom, const uint8_t offset)
+{
+    return PeekToken(offset)->atom == atom;
 }
 
 bool LuaParser::IsType(const Token::Kind val, const uint8_t offset)
@@ -55,23 +180,45 @@ bool LuaParser::IsType(const Token::Kind val, const uint8_t offset)
     return PeekToken(offset)->kind == val;
 }
 
-std::unique_ptr<Token> LuaParser::ExpectValue(std::string_view val)
+TokenRef LuaParser::ExpectValue(Atom::Id atom)
 {
-    if (!IsValue(val))
-        throw Exception("Expected value: " + std::string(val), PeekToken(), PeekToken());
+    if (!IsValue(atom))
+    {
+        Report(ParserDiagnostic::ExpectedToken, PeekRef(), PeekRef(), atom);
+        return TokenRef();
+    }
 
     return ReadToken();
 }
 
-std::unique_ptr<Token> LuaParser::ExpectType(const Token::Kind val)
+TokenRef LuaParser::ExpectType(const Token::Kind val)
 {
     if (!IsType(val))
-        throw Exception("Expected something", PeekToken(), PeekToken());
+    {
+        Report(val == Token::Kind::Letter ? ParserDiagnostic::ExpectedIdentifier : ParserDiagnostic::UnexpectedToken, PeekRef(), PeekRef());
+        return TokenRef();
+    }
 
     return ReadToken();
 }
 
+void LuaParser::Report(ParserDiagnostic::Code code, TokenRef start, TokenRef stop, Atom::Id expected)
+{
+    auto &diagnostics = storage->diagnostics;
+
+    if (!diagnostics.empty() && diagnostics.back().start == start)
+        return;
+
+    diagnostics.push_back({.code = code, .expected = expected, .start = start, .stop = stop});
+}
+
+void LuaParser::SkipToEndOfFile()
+{
+    while (!IsType(Token::Kind::EndOfFile))
+        ReadToken();
+}
+
 bool LuaParser::IsCallExpression(const uint8_t offset)
 {
-    return IsValue("(", offset) || IsValue("<|", offset) || IsValue("{", offset) || IsType(Token::Kind::String, offset) || (IsValue("!", offset) && IsValue("(", offset + 1));
+    return IsValue(Atom::LeftParenthesis, offset) || IsValue(Atom::LeftTypeArguments, offset) || IsValue(Atom::LeftBrace, offset) || IsType(Token::Kind::String, offset) || (IsValue(Atom::Exclamation, offset) && IsValue(Atom::LeftParenthesis, offset + 1));
 }
@@ -1,48 +1,94 @@
 #pragma once
 
+#include <functional>
 #include "../lexer/Token.hpp"
+#include "../lexer/TokenBuffer.hpp"
+#include "../lexer/BaseLexer.hpp"
+#include "./TokenWindow.hpp"
 #include "../syntax/RuntimeSyntax.hpp"
 #include "../syntax/TypesystemSyntax.hpp"
+#include "./ParseResult.hpp"
 #include "./ParserNode.hpp"
 
-using PeekedToken = Token *;
+using PeekedToken = const Token *;
+
+class Expression;
+class Statement;
+class Root;
+
+// a construct ValueExpression::Parse has started but not finished, kept on LuaParser::expression_stack
+// instead of the native stack so deeply nested input cannot overflow it
+struct ExpressionFrame
+{
+    enum Kind : uint8_t
+    {
+        // the ValueExpression::Parse call itself
+        Root,
+        Parentheses,
+        PrefixOperator,
+        BinaryOperator,
+        // a table that is between its children
+        Table,
+        TableKey,
+        TableValue,
+        CallArguments,
+        IndexExpression,
+        TypeCast,
+    };
+
+    Kind kind;
+    // the environment to go back to once the frame is done
+    ParserNode::Environment environment;
+    // binary operators that do not bind tighter than this end the operand of the frame
+    uint8_t priority = 0;
+    ParserNode *node = nullptr;
+    // the opening parenthesis of a Parentheses frame
+    TokenRef token = {};
+};
 
 class LuaParser
 {
 public:
-    class Exception : public std::exception
-    {
-    private:
-        std::string message;
-        PeekedToken start;
-        PeekedToken stop;
+    TokenWindow window;
+    // the nodes and tokens of this parse, shared with every ParseResult made from it
+    std::shared_ptr<ParseStorage> storage = std::make_shared<ParseStorage>();
+    const RuntimeSyntax *runtime_syntax = &RuntimeSyntax::Get();
+    const TypesystemSyntax *typesystem_syntax = &TypesystemSyntax::Get();
+    // which syntax operators are looked up in, type expressions are parsed in the typesystem
+    ParserNode::Environment environment = ParserNode::Runtime;
+    // unfinished expressions of all ValueExpression::Parse calls, kept between files for its capacity
+    std::vector<ExpressionFrame> expression_stack;
+    // deeper nesting is reported and ends the parse, every level of parentheses, tables, calls and right hand sides counts
+    size_t max_expression_depth = 10000;
+    // blocks are parsed recursively, so this bounds the native stack. functions in expressions open a block too
+    // deeper nesting is reported and ends the parse like max_expression_depth
+    size_t max_block_depth = 1000;
+    size_t block_depth = 0;
 
-    public:
-        explicit Exception(const std::string &message, PeekedToken start_token, PeekedToken stop_token)
-        {
-            this->message = message;
+    // nothing to parse until Reset
+    LuaParser();
+    LuaParser(std::vector<std::unique_ptr<Token>> tokens);
+    LuaParser(const TokenBuffer &buffer);
+    // tokens are lexed as the parser asks for them
+    LuaParser(std::shared_ptr<BaseLexer> lexer);
 
-            // TODO: copy?
-            this->start = start_token;
-            this->stop = stop_token;
-        }
-        const char *what() const noexcept override
-        {
-            return message.c_str();
-        }
-    };
+    // nothing is thrown for broken code. errors are recorded in ParseStorage::diagnostics, missing tokens are left empty
+    // and code that cannot be parsed is skipped up to the next place parsing can go on from, see ErrorStatement
 
-    std::vector<std::unique_ptr<Token>> tokens;
-    size_t index = 0;
-    RuntimeSyntax *runtime_syntax = new RuntimeSyntax();
-    TypesystemSyntax *typesystem_syntax = new TypesystemSyntax();
+    // parses one expression, the result keeps the nodes and tokens alive after the parser is gone
+    // the Parse functions of the nodes take the parser by reference and are what this calls
+    ParseResult<Expression> ParseExpression();
+    // parses every statement up to the end of the file
+    ParseResult<Root> ParseFile();
+    // parses the same statements as ParseFile, but hands each top level statement to callback as soon as it is complete,
+    // ending with the EndOfFileStatement. unless callback keeps the ParseResult, the nodes of a statement are reused
+    // for the next one, so node memory is bounded by the largest statement. tokens are not, every result refers to
+    // them by index, so all tokens read so far stay in the store until the parse is over
+    void ParseStatements(const std::function<void(ParseResult<Statement>)> &callback);
 
-    LuaParser(std::vector<std::unique_ptr<Token>> tokens);
-    ~LuaParser()
-    {
-        delete runtime_syntax;
-        delete typesystem_syntax;
-    };
+    // starts parsing the tokens of another file. the arena, token store and side tables of the previous file
+    // are reused unless a ParseResult or analyzer still holds on to them
+    void Reset(const TokenBuffer &buffer);
 
     enum TokenType
     {
@@ -57,15 +103,43 @@ public:
     TokenType GetTokenType(PeekedToken token);
     bool IsTokenValue(PeekedToken token);
 
-    bool IsValue(std::string_view val, const uint8_t offset = 0);
+    bool IsValue(Atom::Id atom, const uint8_t offset = 0);
     bool IsType(const Token::Kind val, const uint8_t offset = 0);
-    std::unique_ptr<Token> ExpectValue(std::string_view val);
-    std::unique_ptr<Token> ExpectType(const Token::Kind val);
+    // reads the token if it is the expected one, otherwise report it and return an empty TokenRef without reading
+    TokenRef ExpectValue(Atom::Id atom);
+    TokenRef ExpectType(const Token::Kind val);
+    // records a diagnostic unless the previous one starts at the same token, so a mistake that leaves several
+    // constructs unfinished is reported once
+    void Report(ParserDiagnostic::Code code, TokenRef start, TokenRef stop, Atom::Id expected = Atom::None);
+    // reads every remaining token, for errors parsing cannot go on after
+    void SkipToEndOfFile();
 
     bool IsCallExpression(const uint8_t offset = 0);
-    std::unique_ptr<Token> ReadToken() { return std::move(tokens[index++]); };
-    PeekedToken PeekToken(size_t offset = 0) { return tokens[index + offset].get(); };
-    void StartNode(ParserNode *node){};
+    TokenRef ReadToken() { return window.Read(); };
+    PeekedToken PeekToken(size_t offset = 0) { return window.Peek(offset); };
+    // the next token without reading it
+    TokenRef PeekRef()
+    {
+        window.Peek();
+        return TokenRef{static_cast<uint32_t>(window.GetIndex())};
+    }
+    const Token &GetToken(TokenRef ref) const { return (*storage->tokens)[ref]; }
+    const BaseSyntax &GetSyntax() const
+    {
+        if (environment == ParserNode::Typesystem)
+            return *typesystem_syntax;
+
+        return *runtime_syntax;
+    }
+    NodeArena &GetArena() { return storage->arena; }
+    template <typename T>
+    T *New() { return storage->arena.New<T>(); }
+    template <typename T>
+    ParseResult<T> Result(T *node) { return ParseResult<T>(node, storage); }
+    void StartNode(ParserNode *node)
+    {
+        node->id = storage->node_count++;
+        node->environment = environment;
+    };
     void EndNode(ParserNode *node){};
-    inline size_t GetLength() { return tokens.size(); }
 };
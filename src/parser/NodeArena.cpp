@@ -0,0 +1,46 @@
+#include "./NodeArena.hpp"
+
+void *NodeArena::Allocate(size_t bytes, size_t alignment)
+{
+    auto padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+
+    if (!cursor || padding + bytes > static_cast<size_t>(limit - cursor))
+    {
+        // large requests get a block of their own so the current block keeps filling up
+        if (bytes + alignment > BLOCK_SIZE / 4)
+        {
+            large_blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(bytes + alignment));
+            capacity += bytes + alignment;
+            size += bytes;
+
+            auto block = large_blocks.back().get();
+            return block + (alignment - reinterpret_cast<uintptr_t>(block) % alignment) % alignment;
+        }
+
+        if (used_blocks == blocks.size())
+        {
+            blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(BLOCK_SIZE));
+            capacity += BLOCK_SIZE;
+        }
+
+        cursor = blocks[used_blocks++].get();
+        limit = cursor + BLOCK_SIZE;
+        padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+    }
+
+    auto memory = cursor + padding;
+    cursor = memory + bytes;
+    size += bytes;
+
+    return memory;
+}
+
+void NodeArena::Reset()
+{
+    large_blocks.clear();
+    used_blocks = 0;
+    cursor = nullptr;
+    limit = nullptr;
+    size = 0;
+    capacity = blocks.size() * BLOCK_SIZE;
+}
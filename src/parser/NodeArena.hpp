@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// bump allocator for the nodes of one parse
+// nothing allocated from it is ever destroyed, the blocks are freed all at once with the arena
+class NodeArena
+{
+public:
+    NodeArena() = default;
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    void *Allocate(size_t bytes, size_t alignment);
+
+    template <typename T, typename... Args>
+    T *New(Args &&...args)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // forgets everything allocated so far, blocks of the standard size are kept and filled again
+    void Reset();
+
+    // bytes handed out so far
+    size_t GetSize() const { return size; }
+    // bytes held in blocks
+    size_t GetCapacity() const { return capacity; }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    // blocks[used_blocks] is the next one to fill
+    size_t used_blocks = 0;
+    std::vector<std::unique_ptr<std::byte[]>> large_blocks;
+    std::byte *cursor = nullptr;
+    std::byte *limit = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+};
+
+// growable array whose elements live in a NodeArena, outgrown storage is left in the arena
+template <typename T>
+class NodeList
+{
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+
+public:
+    void push_back(NodeArena &arena, T value)
+    {
+        if (count == capacity)
+        {
+            auto grown = capacity ? capacity * 2 : 4;
+            auto memory = static_cast<T *>(arena.Allocate(sizeof(T) * grown, alignof(T)));
+
+            if (count)
+                std::memcpy(memory, items, sizeof(T) * count);
+
+            items = memory;
+            capacity = grown;
+        }
+
+        items[count++] = value;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T &operator[](size_t index) const { return items[index]; }
+    T &back() const { return items[count - 1]; }
+    T *begin() const { return items; }
+    T *end() const { return items + count; }
+
+private:
+    T *items = nullptr;
+    uint32_t count = 0;
+    uint32_t capacity = 0;
+};
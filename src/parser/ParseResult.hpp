@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "../lexer/Token.hpp"
+#include "./NodeArena.hpp"
+#include "./ParserDiagnostic.hpp"
+#include "./ParserNode.hpp"
+#include "./TokenStore.hpp"
+
+class Expression;
+
+// everything one parse allocated, nodes live in the arena and refer to tokens by their index in the token store
+struct ParseStorage
+{
+    // the tokens around a parenthesized expression, innermost first
+    struct Parentheses
+    {
+        NodeList<TokenRef> left;
+        NodeList<TokenRef> right;
+    };
+
+    NodeArena arena;
+    std::shared_ptr<const TokenStore> tokens;
+    uint32_t node_count = 0;
+
+    // parts few nodes have, kept out of the nodes and keyed by ParserNode::id
+    std::unordered_map<uint32_t, Parentheses> parentheses;
+    std::unordered_map<uint32_t, TokenRef> type_colon_assignments;
+    std::unordered_map<uint32_t, TokenRef> type_as_assignments;
+    // the annotation after a type colon
+    std::unordered_map<uint32_t, Expression *> type_expressions;
+    // set for most nodes, so indexed by id directly
+    std::vector<ParserNode *> parents;
+    // errors the parser recovered from, in the order they were found
+    std::vector<ParserDiagnostic> diagnostics;
+
+    // empties everything but the tokens for the next file, keeping the arena blocks and table capacity
+    void Reset()
+    {
+        arena.Reset();
+        node_count = 0;
+        parentheses.clear();
+        type_colon_assignments.clear();
+        type_as_assignments.clear();
+        type_expressions.clear();
+        parents.clear();
+        diagnostics.clear();
+    }
+
+    const Parentheses *GetParentheses(const ParserNode *node) const
+    {
+        auto found = parentheses.find(node->id);
+        return found != parentheses.end() ? &found->second : nullptr;
+    }
+    TokenRef GetTypeColonAssignment(const ParserNode *node) const { return Find(type_colon_assignments, node); }
+    TokenRef GetTypeAsAssignment(const ParserNode *node) const { return Find(type_as_assignments, node); }
+    Expression *GetTypeExpression(const ParserNode *node) const
+    {
+        auto found = type_expressions.find(node->id);
+        return found != type_expressions.end() ? found->second : nullptr;
+    }
+    ParserNode *GetParent(const ParserNode *node) const { return node->id < parents.size() ? parents[node->id] : nullptr; }
+    void SetParent(const ParserNode *node, ParserNode *parent)
+    {
+        if (node->id >= parents.size())
+            parents.resize(node->id + 1);
+
+        parents[node->id] = parent;
+    }
+
+private:
+    static TokenRef Find(const std::unordered_map<uint32_t, TokenRef> &table, const ParserNode *node)
+    {
+        auto found = table.find(node->id);
+        return found != table.end() ? found->second : TokenRef();
+    }
+};
+
+// a node from a parse, which keeps the storage of the whole parse alive
+template <typename T>
+class ParseResult
+{
+public:
+    ParseResult() = default;
+    ParseResult(T *node, std::shared_ptr<ParseStorage> storage)
+    {
+        this->node = node;
+        this->storage = std::move(storage);
+    }
+
+    T *get() const { return node; }
+    T *operator->() const { return node; }
+    T &operator*() const { return *node; }
+    explicit operator bool() const { return node != nullptr; }
+    const std::shared_ptr<ParseStorage> &GetStorage() const { return storage; }
+    const TokenStore &GetTokens() const { return *storage->tokens; }
+    const Token &GetToken(TokenRef ref) const { return (*storage->tokens)[ref]; }
+    const std::vector<ParserDiagnostic> &GetDiagnostics() const { return storage->diagnostics; }
+
+private:
+    T *node = nullptr;
+    std::shared_ptr<ParseStorage> storage;
+};
@@ -0,0 +1,45 @@
+#include "./ParserDiagnostic.hpp"
+#include "../syntax/AtomTable.hpp"
+
+static std::string Quote(const Token &token)
+{
+    if (token.kind == Token::Kind::EndOfFile)
+        return "end of file";
+
+    return "'" + std::string(token.value) + "'";
+}
+
+std::string ParserDiagnostic::GetMessage(const TokenStore &tokens) const
+{
+    auto got = Quote(tokens[start]);
+
+    switch (code)
+    {
+    case ExpectedToken:
+        return "expected '" + std::string(AtomTable::GetString(expected)) + "', got " + got;
+    case UnexpectedToken:
+        return "unexpected " + got;
+    case ExpectedIdentifier:
+        return "expected an identifier, got " + got;
+    case ExpectedExpression:
+        return "expected an expression, got " + got;
+    case ExpectedType:
+        return "expected a type, got " + got;
+    case ExpectedFunctionName:
+        return "expected a function name, got " + got;
+    case ExpectedAssignmentOrCall:
+        return "expected assignment or call expression, got " + got;
+    case ExpectedEndOfFile:
+        return "expected end of file, got " + got;
+    case EmptyParentheses:
+        return "empty parentheses group";
+    case NotAssignable:
+        return "cannot assign to this expression";
+    case ExpressionTooDeep:
+        return "expression is nested too deeply";
+    case BlockTooDeep:
+        return "block is nested too deeply";
+    }
+
+    return "unknown error";
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "../syntax/Atom.hpp"
+#include "./TokenStore.hpp"
+
+// a parse error, the message is only built when asked for
+// start and stop are the first and last token it is about, for missing code that is the token found instead
+struct ParserDiagnostic
+{
+    enum Code : uint8_t
+    {
+        // expected is the missing token
+        ExpectedToken,
+        UnexpectedToken,
+        ExpectedIdentifier,
+        ExpectedExpression,
+        ExpectedType,
+        ExpectedFunctionName,
+        ExpectedAssignmentOrCall,
+        ExpectedEndOfFile,
+        EmptyParentheses,
+        NotAssignable,
+        ExpressionTooDeep,
+        BlockTooDeep,
+    };
+
+    Code code;
+    Atom::Id expected = Atom::None;
+    TokenRef start;
+    TokenRef stop;
+
+    std::string GetMessage(const TokenStore &tokens) const;
+};
@@ -1,14 +1,80 @@
 #pragma once
 
+#include <cstdint>
+
+// every concrete node type as X(kind, type), grouped so each base class covers a range of kinds
+#define PARSER_NODE_LIST(X)                                       \
+    X(Atomic, Atomic)                                             \
+    X(Table, Table)                                               \
+    X(PrefixOperator, PrefixOperator)                             \
+    X(BinaryOperator, BinaryOperator)                             \
+    X(Function, Function)                                         \
+    X(Index, ValueExpression::Index)                              \
+    X(SelfCall, ValueExpression::SelfCall)                        \
+    X(Call, ValueExpression::Call)                                \
+    X(PostfixOperator, ValueExpression::PostfixOperator)          \
+    X(IndexExpression, ValueExpression::IndexExpression)          \
+    X(TypeCast, ValueExpression::TypeCast)                        \
+    X(TableIdentifierKeyValue, Table::IdentifierKeyValue)         \
+    X(TableExpressionKeyValue, Table::ExpressionKeyValue)         \
+    X(TableIndexValue, Table::IndexValue)                         \
+    X(ErrorExpression, ErrorExpression)                           \
+    X(Root, Root)                                                 \
+    X(EndOfFileStatement, EndOfFileStatement)                     \
+    X(AnalyzerDebugCodeStatement, AnalyzerDebugCodeStatement)     \
+    X(ParserDebugCodeStatement, ParserDebugCodeStatement)         \
+    X(LocalAssignmentStatement, LocalAssignmentStatement)         \
+    X(AssignmentStatement, AssignmentStatement)                   \
+    X(ExpressionStatement, ExpressionStatement)                   \
+    X(IfStatement, IfStatement)                                   \
+    X(NumericForStatement, NumericForStatement)                   \
+    X(GenericForStatement, GenericForStatement)                   \
+    X(WhileStatement, WhileStatement)                             \
+    X(RepeatStatement, RepeatStatement)                           \
+    X(DoStatement, DoStatement)                                   \
+    X(ReturnStatement, ReturnStatement)                           \
+    X(BreakStatement, BreakStatement)                             \
+    X(ContinueStatement, ContinueStatement)                       \
+    X(GotoStatement, GotoStatement)                               \
+    X(GotoLabelStatement, GotoLabelStatement)                     \
+    X(SemicolonStatement, SemicolonStatement)                     \
+    X(FunctionStatement, FunctionStatement)                       \
+    X(LocalFunctionStatement, LocalFunctionStatement)             \
+    X(ErrorStatement, ErrorStatement)
+
 class ParserNode
 {
 public:
-    enum Environment
+    enum class Kind : uint8_t
+    {
+#define X(kind, type) kind,
+        PARSER_NODE_LIST(X)
+#undef X
+    };
+
+    enum Environment : uint8_t
     {
         Runtime,
         Typesystem,
     };
-    ParserNode *parent = nullptr;
+
+    // index of the node within its parse, optional parts such as parentheses are kept in ParseStorage under it
+    uint32_t id = 0;
+    Kind kind;
     Environment environment = Runtime;
-    virtual void lol(){};
+
+    static constexpr bool IsKind(Kind) { return true; }
+
+protected:
+    explicit ParserNode(Kind kind)
+    {
+        this->kind = kind;
+    }
 };
+
+// static_cast to T if the node is one, nullptr otherwise
+template <typename T>
+inline T *NodeCast(ParserNode *node)
+{
+    return node && T::IsKind(node->kind) ? static_cast<T *>(node) : nullptr;
+}
@@ -1,395 +1,662 @@
 #include "./PrimaryExpression.hpp"
+#include "./Statement.hpp"
 
-std::unique_ptr<Atomic> Atomic::Parse(std::shared_ptr<LuaParser> parser)
+Atomic *Atomic::Parse(LuaParser &parser)
 {
-    if (!parser->IsTokenValue(parser->PeekToken()))
+    if (!parser.IsTokenValue(parser.PeekToken()))
         return nullptr;
 
-    auto node = std::make_unique<Atomic>();
-    parser->StartNode(node.get());
-    node->value = parser->ReadToken();
-    parser->EndNode(node.get());
-    node->token_type = parser->GetTokenType(node->value.get());
+    auto node = parser.New<Atomic>();
+    parser.StartNode(node);
+    node->token_type = parser.GetTokenType(parser.PeekToken());
+    node->value = parser.ReadToken();
+    parser.EndNode(node);
 
     return node;
 };
 
-std::unique_ptr<Table::IdentifierKeyValue> Table::IdentifierKeyValue::Parse(std::shared_ptr<LuaParser> parser)
+// a type expression after a colon, the colon is read already
+static Expression *ParseTypeExpression(LuaParser &parser)
 {
-    if (!parser->IsType(Token::Kind::Letter) || !parser->IsValue("=", 1))
-        return nullptr;
+    auto environment = parser.environment;
+    parser.environment = ParserNode::Typesystem;
+    auto node = ValueExpression::Parse(parser);
+    parser.environment = environment;
+
+    if (!node)
+        return ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedType);
 
-    auto node = std::make_unique<IdentifierKeyValue>();
-    parser->StartNode(node.get());
-    node->key = parser->ExpectType(Token::Kind::Letter);
-    node->tk_equal = parser->ExpectValue("=");
-    node->val = ValueExpression::Parse(parser);
-    parser->EndNode(node.get());
     return node;
 }
 
-std::unique_ptr<Table::ExpressionKeyValue> Table::ExpressionKeyValue::Parse(std::shared_ptr<LuaParser> parser)
+Atomic *Atomic::ParseIdentifier(LuaParser &parser)
 {
-    if (!parser->IsValue("["))
+    auto token = parser.PeekToken();
+    auto is_name = token->kind == Token::Kind::Letter && !parser.GetSyntax().IsKeyword(token->atom) && !parser.GetSyntax().IsKeywordValue(token->atom);
+
+    if (!is_name && token->atom != Atom::Ellipsis)
+    {
+        parser.Report(ParserDiagnostic::ExpectedIdentifier, parser.PeekRef(), parser.PeekRef());
         return nullptr;
+    }
 
-    auto node = std::make_unique<ExpressionKeyValue>();
-    parser->StartNode(node.get());
-    node->tk_left_bracket = parser->ExpectValue("[");
-    node->key = ValueExpression::Parse(parser);
-    node->tk_right_bracket = parser->ExpectValue("]");
-    node->tk_equal = parser->ExpectValue("=");
-    node->val = ValueExpression::Parse(parser);
-    parser->EndNode(node.get());
+    auto node = Atomic::Parse(parser);
+
+    if (parser.IsValue(Atom::Colon))
+    {
+        parser.storage->type_colon_assignments[node->id] = parser.ReadToken();
+        parser.storage->type_expressions[node->id] = ParseTypeExpression(parser);
+    }
 
     return node;
-};
+}
 
-std::unique_ptr<Table::IndexValue> Table::IndexValue::Parse(std::shared_ptr<LuaParser> parser)
+ErrorExpression *ErrorExpression::Missing(LuaParser &parser, ParserDiagnostic::Code code)
 {
-    auto node = std::make_unique<IndexValue>();
-    parser->StartNode(node.get());
-    node->val = ValueExpression::Parse(parser);
-    parser->EndNode(node.get());
+    auto node = parser.New<ErrorExpression>();
+    parser.StartNode(node);
+    node->token = parser.PeekRef();
+    parser.Report(code, node->token, node->token);
+    parser.EndNode(node);
 
     return node;
 }
 
-std::unique_ptr<Table> Table::Parse(std::shared_ptr<LuaParser> parser)
+// keywords that end the expression they are in, broken code in a list is never skipped past them
+static bool IsExpressionBoundary(LuaParser &parser)
 {
-    if (!parser->IsValue("{"))
-        return nullptr;
+    auto token = parser.PeekToken();
 
-    auto node = std::make_unique<Table>();
-    parser->StartNode(node.get());
+    if (token->kind == Token::Kind::EndOfFile)
+        return true;
 
-    node->tk_left_bracket = parser->ExpectValue("{");
+    switch (token->atom)
+    {
+    case Atom::End:
+    case Atom::Else:
+    case Atom::ElseIf:
+    case Atom::Until:
+    case Atom::Then:
+    case Atom::Do:
+    case Atom::In:
+    case Atom::Local:
+    case Atom::If:
+    case Atom::For:
+    case Atom::While:
+    case Atom::Repeat:
+    case Atom::Return:
+    case Atom::Break:
+        return true;
+    default:
+        return false;
+    }
+}
 
-    size_t index = 0;
+// reports that a separator or close was expected and skips to the next one, brackets opened in the skipped
+// code are skipped whole. stops early at an expression boundary
+static void SkipToSeparator(LuaParser &parser, Atom::Id close)
+{
+    auto start = parser.PeekRef();
+    auto stop = start;
+    size_t depth = 0;
 
-    while (true)
+    while (!IsExpressionBoundary(parser))
     {
-        if (parser->IsValue("}"))
+        auto atom = parser.PeekToken()->atom;
+
+        if (depth == 0 && (atom == Atom::Comma || atom == close || (close == Atom::RightBrace && atom == Atom::Semicolon)))
             break;
 
-        std::unique_ptr<Child> child = nullptr;
+        if (atom == Atom::LeftParenthesis || atom == Atom::LeftBrace || atom == Atom::LeftBracket)
+            depth++;
+        else if ((atom == Atom::RightParenthesis || atom == Atom::RightBrace || atom == Atom::RightBracket) && depth > 0)
+            depth--;
 
-        if (auto res = ExpressionKeyValue::Parse(parser))
-        {
-            child = std::move(res);
-        }
-        else if (auto res = IdentifierKeyValue::Parse(parser))
-        {
-            child = std::move(res);
-        }
-        else if (auto res = IndexValue::Parse(parser))
-        {
-            res->key = index;
-            child = std::move(res);
-        }
+        stop = parser.ReadToken();
+    }
 
-        node->children.push_back(std::move(child));
+    parser.Report(ParserDiagnostic::ExpectedToken, start, stop, close);
+}
 
-        if (!parser->IsValue(",") && !parser->IsValue(";") && !parser->IsValue("}"))
-        {
-            throw LuaParser::Exception("Expected something", parser->PeekToken(), parser->PeekToken());
-        }
+// opens a frame, every open frame counts towards LuaParser::max_expression_depth
+// past it the rest of the file is skipped, so the open frames are closed at the end of the file
+static void PushFrame(LuaParser &parser, ExpressionFrame frame)
+{
+    if (parser.expression_stack.size() >= parser.max_expression_depth && !parser.IsType(Token::Kind::EndOfFile))
+    {
+        parser.Report(ParserDiagnostic::ExpressionTooDeep, parser.PeekRef(), parser.PeekRef());
+        parser.SkipToEndOfFile();
+    }
 
-        if (!parser->IsValue("}"))
-            node->tk_separators.push_back(parser->ExpectValue(","));
+    parser.expression_stack.push_back(frame);
+}
 
-        index++;
+// starts the next child of the table on top of the stack or closes it at its right brace
+// returns the table once it is closed and nullptr while a child waits for its expression
+static Table *ContinueTable(LuaParser &parser, Table *table)
+{
+    if (parser.IsValue(Atom::RightBrace) || IsExpressionBoundary(parser))
+    {
+        table->tk_right_bracket = parser.ExpectValue(Atom::RightBrace);
+        parser.EndNode(table);
+        parser.expression_stack.pop_back();
+        return table;
     }
 
-    node->tk_right_bracket = parser->ExpectValue("}");
+    Table::Child *child = nullptr;
+    auto kind = ExpressionFrame::TableValue;
 
-    parser->EndNode(node.get());
+    if (parser.IsValue(Atom::LeftBracket))
+    {
+        auto key_value = parser.New<Table::ExpressionKeyValue>();
+        parser.StartNode(key_value);
+        key_value->tk_left_bracket = parser.ReadToken();
+        child = key_value;
+        kind = ExpressionFrame::TableKey;
+    }
+    else if (parser.IsType(Token::Kind::Letter) && parser.IsValue(Atom::Assign, 1))
+    {
+        auto key_value = parser.New<Table::IdentifierKeyValue>();
+        parser.StartNode(key_value);
+        key_value->key = parser.ReadToken();
+        key_value->tk_equal = parser.ReadToken();
+        child = key_value;
+    }
+    else
+    {
+        auto index_value = parser.New<Table::IndexValue>();
+        parser.StartNode(index_value);
+        index_value->key = table->children.size();
+        child = index_value;
+    }
 
-    return node;
-};
+    PushFrame(parser, {.kind = kind, .environment = parser.environment, .node = child});
+    return nullptr;
+}
 
-std::unique_ptr<PrefixOperator> PrefixOperator::Parse(std::shared_ptr<LuaParser> parser)
+static Table *StartTable(LuaParser &parser)
 {
-    if (!parser->runtime_syntax->IsPrefixOperator(parser->PeekToken()->value))
-        return nullptr;
+    auto table = parser.New<Table>();
+    parser.StartNode(table);
+    table->tk_left_bracket = parser.ReadToken();
+    PushFrame(parser, {.kind = ExpressionFrame::Table, .environment = parser.environment, .node = table});
 
-    auto node = std::make_unique<PrefixOperator>();
-    parser->StartNode(node.get());
-    node->op = parser->ReadToken();
-    node->right = ValueExpression::Parse(parser);
-    parser->EndNode(node.get());
-    return node;
-};
+    return ContinueTable(parser, table);
+}
 
-std::unique_ptr<BinaryOperator> BinaryOperator::Parse(std::shared_ptr<LuaParser> parser)
+// the child on top of the stack got its value, the table below it goes on with the next one
+static Table *FinishTableChild(LuaParser &parser, Expression *value)
 {
-    if (!parser->runtime_syntax->IsBinaryOperator(parser->PeekToken()->value))
-        return nullptr;
+    auto child = static_cast<Table::Child *>(parser.expression_stack.back().node);
 
-    auto node = std::make_unique<BinaryOperator>();
-    parser->StartNode(node.get());
-    node->left = ValueExpression::Parse(parser);
-    node->op = parser->ReadToken();
-    node->right = ValueExpression::Parse(parser);
-    parser->EndNode(node.get());
-    return node;
-};
+    if (!value)
+        value = ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedExpression);
+
+    if (auto key_value = NodeCast<Table::IdentifierKeyValue>(child))
+        key_value->val = value;
+    else if (auto key_value = NodeCast<Table::ExpressionKeyValue>(child))
+        key_value->val = value;
+    else
+        static_cast<Table::IndexValue *>(child)->val = value;
+
+    parser.EndNode(child);
+    parser.expression_stack.pop_back();
+
+    auto table = static_cast<Table *>(parser.expression_stack.back().node);
+    table->children.push_back(parser.GetArena(), child);
+
+    if (!parser.IsValue(Atom::Comma) && !parser.IsValue(Atom::Semicolon) && !parser.IsValue(Atom::RightBrace))
+        SkipToSeparator(parser, Atom::RightBrace);
 
-std::unique_ptr<Expression> ValueExpression::Parse(std::shared_ptr<LuaParser> parser, size_t priority)
+    if (parser.IsValue(Atom::Comma) || parser.IsValue(Atom::Semicolon))
+        table->tk_separators.push_back(parser.GetArena(), parser.ReadToken());
+
+    return ContinueTable(parser, table);
+}
+
+static Atom::Id GetArgumentsRight(LuaParser &parser, ValueExpression::Call *call)
 {
-    std::unique_ptr<Expression> node = nullptr;
+    return parser.GetToken(call->tk_arguments_left).atom == Atom::LeftTypeArguments ? Atom::RightTypeArguments : Atom::RightParenthesis;
+}
 
-    if (parser->IsValue("("))
-    {
-        auto left_paren = parser->ExpectValue("(");
-        node = ValueExpression::Parse(parser);
-        auto right_paren = parser->ExpectValue(")");
+// closes the call on top of the stack, a missing right parenthesis is reported already
+static ValueExpression::Call *FinishCall(LuaParser &parser)
+{
+    auto &frame = parser.expression_stack.back();
+    auto call = static_cast<ValueExpression::Call *>(frame.node);
+    parser.environment = frame.environment;
 
-        if (!node)
-        {
-            throw LuaParser::Exception("Empty parentheses group", parser->PeekToken(), parser->PeekToken());
-        }
+    if (call->tk_arguments_left && parser.IsValue(GetArgumentsRight(parser, call)))
+        call->tk_arguments_right = parser.ReadToken();
 
-        node->tk_left_parenthesis.push_back(std::move(left_paren)); // TODO: unshift
-        node->tk_right_parenthesis.push_back(std::move(right_paren));
-    }
-    else if (auto res = Atomic::Parse(parser))
-    {
-        node = std::move(res);
-    }
-    else if (auto res = Table::Parse(parser))
-    {
-        node = std::move(res);
-    }
-    else if (auto res = PrefixOperator::Parse(parser))
+    parser.EndNode(call);
+    parser.expression_stack.pop_back();
+    return call;
+}
+
+// returns the call once it is closed and nullptr while it waits for an argument
+static ValueExpression::Call *StartCall(LuaParser &parser, Expression *left)
+{
+    auto call = parser.New<ValueExpression::Call>();
+    parser.StartNode(call);
+    call->left = left;
+
+    if (parser.IsType(Token::Kind::String))
     {
-        node = std::move(res);
+        call->arguments.push_back(parser.GetArena(), Atomic::Parse(parser));
+        parser.EndNode(call);
+        return call;
     }
-    else if (auto res = Function::Parse(parser))
+
+    PushFrame(parser, {.kind = ExpressionFrame::CallArguments, .environment = parser.environment, .node = call});
+
+    if (parser.IsValue(Atom::LeftBrace))
     {
-        node = std::move(res);
+        if (auto table = StartTable(parser))
+        {
+            call->arguments.push_back(parser.GetArena(), table);
+            return FinishCall(parser);
+        }
+
+        return nullptr;
     }
 
-    while (node)
+    if (parser.IsValue(Atom::Exclamation))
+        call->tk_type_call = parser.ReadToken();
+
+    // type arguments are parsed in the typesystem
+    if (call->tk_type_call || parser.IsValue(Atom::LeftTypeArguments))
+        parser.environment = ParserNode::Typesystem;
+
+    call->tk_arguments_left = parser.ReadToken();
+
+    if (parser.IsValue(Atom::RightParenthesis) || parser.IsValue(Atom::RightTypeArguments))
+        return FinishCall(parser);
+
+    return nullptr;
+}
+
+Expression *ValueExpression::Parse(LuaParser &parser, size_t priority)
+{
+    auto &stack = parser.expression_stack;
+
+    // one allocation covers the nesting of ordinary code
+    if (stack.capacity() == 0)
+        stack.reserve(32);
+
+    PushFrame(parser, {.kind = ExpressionFrame::Root, .environment = parser.environment, .priority = static_cast<uint8_t>(priority)});
+
+    enum
     {
-        std::unique_ptr<PostfixExpression> sub = nullptr;
+        Operand,
+        Postfix,
+        Operator,
+    } step = Operand;
 
-        if (auto res = Index::Parse(parser))
-        {
-            sub = std::move(res);
-        }
-        else if (auto res = SelfCall::Parse(parser))
-        {
-            sub = std::move(res);
-        }
-        else if (auto res = Call::Parse(parser))
+    Expression *node = nullptr;
+    // binary operator after node, if any
+    const OperatorInfo *info = nullptr;
+
+    while (true)
+    {
+        if (step == Operand)
         {
-            sub = std::move(res);
+            node = nullptr;
+            step = Postfix;
+
+            if (parser.IsValue(Atom::LeftParenthesis))
+            {
+                auto left_paren = parser.ReadToken();
+                PushFrame(parser, {.kind = ExpressionFrame::Parentheses, .environment = parser.environment, .token = left_paren});
+                step = Operand;
+                continue;
+            }
+            else if (auto res = Atomic::Parse(parser))
+            {
+                node = res;
+            }
+            else if (parser.IsValue(Atom::LeftBrace))
+            {
+                node = StartTable(parser);
+
+                if (!node)
+                {
+                    step = Operand;
+                    continue;
+                }
+            }
+            else if (auto info = parser.GetSyntax().GetPrefixOperatorInfo(parser.PeekToken()->atom))
+            {
+                auto prefix = parser.New<PrefixOperator>();
+                parser.StartNode(prefix);
+                prefix->op = parser.ReadToken();
+                PushFrame(parser, {.kind = ExpressionFrame::PrefixOperator, .environment = parser.environment, .priority = info->right_priority, .node = prefix});
+                step = Operand;
+                continue;
+            }
+            else if (auto res = Function::Parse(parser))
+            {
+                node = res;
+            }
         }
-        else if (auto res = PostfixOperator::Parse(parser))
+
+        if (step == Postfix)
         {
-            sub = std::move(res);
+            while (node)
+            {
+                // no postfix starts with a binary operator, which is what usually follows an operand
+                info = parser.GetSyntax().GetBinaryOperatorInfo(parser.PeekToken()->atom);
+
+                if (info)
+                    break;
+
+                if (auto res = Index::Parse(parser))
+                {
+                    res->left = node;
+                    node = res;
+                }
+                else if (auto res = SelfCall::Parse(parser))
+                {
+                    res->left = node;
+                    node = res;
+                }
+                else if (parser.IsCallExpression(0))
+                {
+                    node = StartCall(parser, node);
+
+                    if (!node)
+                    {
+                        step = Operand;
+                        break;
+                    }
+                }
+                else if (auto res = PostfixOperator::Parse(parser))
+                {
+                    res->left = node;
+                    node = res;
+                }
+                else if (parser.IsValue(Atom::LeftBracket))
+                {
+                    auto index = parser.New<IndexExpression>();
+                    parser.StartNode(index);
+                    index->left = node;
+                    index->tk_left_bracket = parser.ReadToken();
+                    PushFrame(parser, {.kind = ExpressionFrame::IndexExpression, .environment = parser.environment, .node = index});
+                    step = Operand;
+                    break;
+                }
+                else if ((parser.IsValue(Atom::Colon) && !parser.IsType(Token::Kind::Letter, 1) && !parser.IsCallExpression(2)) || parser.IsValue(Atom::As))
+                {
+                    auto cast = parser.New<TypeCast>();
+                    parser.StartNode(cast);
+                    cast->left = node;
+                    cast->tk_operator = parser.ReadToken(); // either as or :
+                    PushFrame(parser, {.kind = ExpressionFrame::TypeCast, .environment = parser.environment, .node = cast});
+                    parser.environment = ParserNode::Typesystem;
+                    step = Operand;
+                    break;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            // a postfix that opened a frame waits for its operand
+            if (step == Operand)
+                continue;
+
+            // stays valid while frames are finished, as they do not move past the operator token
+            if (!node)
+                info = nullptr;
+
+            step = Operator;
         }
-        else if (auto res = IndexExpression::Parse(parser))
+
+        // the operand is complete, it either becomes the left side of a binary operator or finishes the frame on top
+        auto &frame = stack.back();
+
+        if (info && info->left_priority > frame.priority)
         {
-            sub = std::move(res);
+            auto binary = parser.New<BinaryOperator>();
+            parser.StartNode(binary);
+            binary->op = parser.ReadToken();
+            binary->left = node;
+            parser.storage->SetParent(binary->left, binary);
+            PushFrame(parser, {.kind = ExpressionFrame::BinaryOperator, .environment = parser.environment, .priority = info->right_priority, .node = binary});
+            step = Operand;
+            continue;
         }
-        else if (auto res = TypeCast::Parse(parser))
+
+        switch (frame.kind)
         {
-            sub = std::move(res);
-        }
+        case ExpressionFrame::Root:
+            parser.environment = frame.environment;
+            stack.pop_back();
+            return node;
 
-        if (!sub)
+        case ExpressionFrame::Parentheses:
         {
-            break;
-        }
+            auto left_paren = frame.token;
 
-        sub->left = std::move(node);
-        node = std::move(sub);
-    }
+            if (!node)
+                node = ErrorExpression::Missing(parser, ParserDiagnostic::EmptyParentheses);
 
-    // check integer
+            auto right_paren = parser.ExpectValue(Atom::RightParenthesis);
 
-    while (node)
-    {
-        auto info = parser->runtime_syntax->GetBinaryOperatorInfo(parser->PeekToken()->value);
-        if (!info || info->left_priority < priority)
+            auto &parentheses = parser.storage->parentheses[node->id];
+            parentheses.left.push_back(parser.GetArena(), left_paren); // TODO: unshift
+            parentheses.right.push_back(parser.GetArena(), right_paren);
+
+            stack.pop_back();
+            step = Postfix;
             break;
+        }
 
-        auto left_node = std::move(node);
+        case ExpressionFrame::PrefixOperator:
+        case ExpressionFrame::BinaryOperator:
+        {
+            if (!node)
+                node = ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedExpression);
 
-        auto binary = std::make_unique<BinaryOperator>();
-        parser->StartNode(binary.get());
-        binary->op = parser->ReadToken();
-        binary->left = std::move(left_node);
-        binary->left->parent = node.get();
+            if (auto binary = NodeCast<BinaryOperator>(frame.node))
+                binary->right = node;
+            else
+                static_cast<PrefixOperator *>(frame.node)->right = node;
 
-        binary->right = ValueExpression::Parse(parser, info->right_priority);
+            parser.EndNode(frame.node);
+            node = static_cast<Expression *>(frame.node);
+            stack.pop_back();
+            break;
+        }
 
-        if (!binary->right)
+        case ExpressionFrame::TableKey:
         {
-            auto token = parser->PeekToken();
-            throw LuaParser::Exception(
-                "expected right side to be an expression, got $1",
-                token,
-                token);
-        }
+            auto key_value = static_cast<Table::ExpressionKeyValue *>(frame.node);
 
-        parser->EndNode(binary.get());
+            if (!node)
+                node = ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedExpression);
 
-        node = std::move(binary);
-    }
+            key_value->key = node;
+            key_value->tk_right_bracket = parser.ExpectValue(Atom::RightBracket);
+            key_value->tk_equal = parser.ExpectValue(Atom::Assign);
+            frame.kind = ExpressionFrame::TableValue;
+            step = Operand;
+            break;
+        }
 
-    return node;
-}
+        case ExpressionFrame::TableValue:
+            node = FinishTableChild(parser, node);
+            step = node ? Postfix : Operand;
 
-std::unique_ptr<ValueExpression::Index> ValueExpression::Index::Parse(std::shared_ptr<LuaParser> parser)
-{
-    if (!parser->IsValue(".") || !parser->IsType(Token::Kind::Letter, 1))
-        return nullptr;
+            // the table of f{...} is the whole argument list, so the call ends with it
+            if (node && stack.back().kind == ExpressionFrame::CallArguments)
+            {
+                auto call = static_cast<Call *>(stack.back().node);
 
-    auto node = std::make_unique<Index>();
-    parser->StartNode(node.get());
-    node->op = parser->ReadToken();
-    node->right = Atomic::Parse(parser);
-    parser->EndNode(node.get());
+                if (!call->tk_arguments_left)
+                {
+                    call->arguments.push_back(parser.GetArena(), node);
+                    node = FinishCall(parser);
+                }
+            }
 
-    return node;
-}
+            break;
 
-std::unique_ptr<ValueExpression::SelfCall> ValueExpression::SelfCall::Parse(std::shared_ptr<LuaParser> parser)
-{
-    if (!(parser->IsValue(":") && parser->IsType(Token::Kind::Letter, 1) && parser->IsCallExpression(2)))
-        return nullptr;
+        case ExpressionFrame::CallArguments:
+        {
+            auto call = static_cast<Call *>(frame.node);
 
-    auto node = std::make_unique<SelfCall>();
-    parser->StartNode(node.get());
-    node->op = parser->ReadToken();
+            if (!node)
+                node = ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedExpression);
 
-    node->right = Atomic::Parse(parser);
+            call->arguments.push_back(parser.GetArena(), node);
 
-    parser->EndNode(node.get());
+            if (call->tk_arguments_left && !parser.IsValue(Atom::Comma) && !parser.IsValue(GetArgumentsRight(parser, call)))
+                SkipToSeparator(parser, GetArgumentsRight(parser, call));
 
-    return node;
-}
+            if (call->tk_arguments_left && parser.IsValue(Atom::Comma))
+            {
+                call->tk_comma.push_back(parser.GetArena(), parser.ReadToken());
+                step = Operand;
+                break;
+            }
 
-std::unique_ptr<ValueExpression::Call> ValueExpression::Call::Parse(std::shared_ptr<LuaParser> parser)
-{
-    if (!parser->IsCallExpression(0))
-        return nullptr;
+            node = FinishCall(parser);
+            step = Postfix;
+            break;
+        }
 
-    auto node = std::make_unique<Call>();
-    parser->StartNode(node.get());
+        case ExpressionFrame::IndexExpression:
+        {
+            auto index = static_cast<IndexExpression *>(frame.node);
 
-    if (parser->IsValue("{"))
-    {
-        node->arguments.push_back(Table::Parse(parser));
-    }
-    else if (parser->IsType(Token::Kind::String))
-    {
-        node->arguments.push_back(Atomic::Parse(parser));
-    }
-    else if (parser->IsValue("("))
-    {
-        node->tk_arguments_left = parser->ReadToken();
+            if (!node)
+                node = ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedExpression);
 
-        for (size_t i = 0; i < 1000; i++)
-        {
-            auto value = Atomic::Parse(parser);
-            if (!value)
-                break;
+            index->index = node;
+            index->tk_right_bracket = parser.ExpectValue(Atom::RightBracket);
+            parser.EndNode(index);
+            node = index;
+            stack.pop_back();
+            step = Postfix;
+            break;
+        }
 
-            node->arguments.push_back(std::move(value));
+        case ExpressionFrame::TypeCast:
+        {
+            auto cast = static_cast<TypeCast *>(frame.node);
 
-            if (!parser->IsValue(","))
-                break;
+            if (!node)
+                node = ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedType);
 
-            node->tk_comma.push_back(parser->ExpectValue(","));
+            parser.environment = frame.environment;
+            cast->expression = node;
+            parser.EndNode(cast);
+            node = cast;
+            stack.pop_back();
+            step = Postfix;
+            break;
         }
 
-        node->tk_arguments_right = parser->ReadToken();
+        case ExpressionFrame::Table:
+            // tables only ever see the values of their children
+            __builtin_unreachable();
+        }
     }
-
-    return node;
 }
 
-std::unique_ptr<ValueExpression::PostfixOperator> ValueExpression::PostfixOperator::Parse(std::shared_ptr<LuaParser> parser)
+ValueExpression::Index *ValueExpression::Index::Parse(LuaParser &parser)
 {
-    if (!parser->runtime_syntax->IsPostfixOperator(parser->PeekToken()->value))
+    if (!parser.IsValue(Atom::Dot) || !parser.IsType(Token::Kind::Letter, 1))
         return nullptr;
 
-    auto node = std::make_unique<PostfixOperator>();
-    parser->StartNode(node.get());
-    node->op = parser->ReadToken();
-    parser->EndNode(node.get());
+    auto node = parser.New<Index>();
+    parser.StartNode(node);
+    node->op = parser.ReadToken();
+    node->right = Atomic::Parse(parser);
+    parser.EndNode(node);
 
     return node;
 }
 
-std::unique_ptr<ValueExpression::IndexExpression> ValueExpression::IndexExpression::Parse(std::shared_ptr<LuaParser> parser)
+ValueExpression::SelfCall *ValueExpression::SelfCall::Parse(LuaParser &parser)
 {
-    if (!parser->IsValue("["))
+    if (!(parser.IsValue(Atom::Colon) && parser.IsType(Token::Kind::Letter, 1) && parser.IsCallExpression(2)))
         return nullptr;
 
-    auto node = std::make_unique<IndexExpression>();
-    parser->StartNode(node.get());
+    auto node = parser.New<SelfCall>();
+    parser.StartNode(node);
+    node->op = parser.ReadToken();
 
-    node->tk_left_bracket = parser->ReadToken();
-    node->index = ValueExpression::Parse(parser);
-    node->tk_right_bracket = parser->ReadToken();
+    node->right = Atomic::Parse(parser);
 
-    parser->EndNode(node.get());
+    parser.EndNode(node);
 
     return node;
 }
 
-std::unique_ptr<ValueExpression::TypeCast> ValueExpression::TypeCast::Parse(std::shared_ptr<LuaParser> parser)
+ValueExpression::PostfixOperator *ValueExpression::PostfixOperator::Parse(LuaParser &parser)
 {
-    if ((!parser->IsValue(":") || (parser->IsType(Token::Kind::Letter, 1) || parser->IsCallExpression(2))) && !parser->IsValue("as"))
-    {
+    if (!parser.GetSyntax().IsPostfixOperator(parser.PeekToken()->atom))
         return nullptr;
-    }
 
-    auto node = std::make_unique<TypeCast>();
-    parser->StartNode(node.get());
-    node->tk_operator = parser->ReadToken(); // either as or :
-    node->expression = ValueExpression::Parse(parser);
-    parser->EndNode(node.get());
+    auto node = parser.New<PostfixOperator>();
+    parser.StartNode(node);
+    node->op = parser.ReadToken();
+    parser.EndNode(node);
 
     return node;
 }
 
-std::unique_ptr<Function> Function::Parse(std::shared_ptr<LuaParser> parser)
+Function *Function::Parse(LuaParser &parser)
 {
-    if (!parser->IsValue("function"))
+    if (!parser.IsValue(Atom::Function))
         return nullptr;
 
-    auto node = std::make_unique<Function>();
-    parser->StartNode(node.get());
+    auto node = parser.New<Function>();
+    parser.StartNode(node);
+    node->tk_function = parser.ReadToken();
+    ParseBody(parser, node);
 
-    node->tk_function = parser->ExpectValue("function");
-    node->tk_arguments_left = parser->ExpectValue("(");
+    return node;
+}
 
-    for (size_t i = 0; i < 1000; i++)
-    {
-        auto exp = ValueExpression::Parse(parser);
-        if (!exp)
-            break;
+void Function::ParseBody(LuaParser &parser, Function *node)
+{
+    node->tk_arguments_left = parser.ExpectValue(Atom::LeftParenthesis);
 
-        node->arguments.push_back(std::move(exp));
+    if (!parser.IsValue(Atom::RightParenthesis))
+    {
+        while (true)
+        {
+            if (auto argument = Atomic::ParseIdentifier(parser))
+                node->arguments.push_back(parser.GetArena(), argument);
+            else
+                SkipToSeparator(parser, Atom::RightParenthesis);
 
-        if (!parser->IsValue(","))
-            break;
+            if (!parser.IsValue(Atom::Comma))
+                break;
 
-        node->tk_argument_separators.push_back(std::move(parser->ReadToken()));
+            node->tk_argument_separators.push_back(parser.GetArena(), parser.ReadToken());
+        }
     }
 
-    node->tk_arguments_right = parser->ExpectValue(")");
-    node->tk_end = parser->ExpectValue("end");
+    node->tk_arguments_right = parser.ExpectValue(Atom::RightParenthesis);
 
-    // node->statements = parser->ParseBlock();
+    if (parser.IsValue(Atom::Colon))
+    {
+        parser.storage->type_colon_assignments[node->id] = parser.ReadToken();
+        node->return_types.push_back(parser.GetArena(), ParseTypeExpression(parser));
 
-    parser->EndNode(node.get());
+        while (parser.IsValue(Atom::Comma))
+        {
+            node->tk_return_separators.push_back(parser.GetArena(), parser.ReadToken());
+            node->return_types.push_back(parser.GetArena(), ParseTypeExpression(parser));
+        }
+    }
 
-    return node;
+    node->statements = Statement::ParseBlock(parser);
+    node->tk_end = parser.ExpectValue(Atom::End);
+    parser.EndNode(node);
 }
@@ -4,171 +4,224 @@
 #include "./LuaParser.hpp"
 #include "./ParserNode.hpp"
 
+class Statement;
+
 class Expression : public ParserNode
 {
 public:
-    std::vector<std::unique_ptr<Token>> tk_left_parenthesis = {};
-    std::vector<std::unique_ptr<Token>> tk_right_parenthesis = {};
-
-    std::unique_ptr<Token> tk_type_colon_assignment = nullptr;
-    std::unique_ptr<Token> tk_type_as_assignment = nullptr;
+    explicit Expression(Kind kind) : ParserNode(kind) {}
 };
 
 class ValueExpression : public Expression
 {
 public:
-    static std::unique_ptr<Expression> Parse(std::shared_ptr<LuaParser> parser, size_t priority = 0);
+    explicit ValueExpression(Kind kind) : Expression(kind) {}
+    static constexpr bool IsKind(Kind kind) { return kind >= Kind::Atomic && kind <= Kind::Function; }
+
+    static Expression *Parse(LuaParser &parser, size_t priority = 0);
 
     class PostfixExpression : public Expression
     {
     public:
-        std::unique_ptr<Expression> left;
+        explicit PostfixExpression(Kind kind) : Expression(kind) {}
+        static constexpr bool IsKind(Kind kind) { return kind >= Kind::Index && kind <= Kind::TypeCast; }
+
+        Expression *left = nullptr;
     };
     class Index : public PostfixExpression
     {
     public:
-        std::unique_ptr<Token> op;
-        std::unique_ptr<Expression> right;
+        Index() : PostfixExpression(Kind::Index) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::Index; }
+
+        TokenRef op;
+        Expression *right = nullptr;
 
-        static std::unique_ptr<Index> Parse(std::shared_ptr<LuaParser> parser);
+        static Index *Parse(LuaParser &parser);
     };
 
     class SelfCall : public PostfixExpression
     {
     public:
-        std::unique_ptr<Token> op;
-        std::unique_ptr<Expression> right;
+        SelfCall() : PostfixExpression(Kind::SelfCall) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::SelfCall; }
 
-        static std::unique_ptr<SelfCall> Parse(std::shared_ptr<LuaParser> parser);
+        TokenRef op;
+        Expression *right = nullptr;
+
+        static SelfCall *Parse(LuaParser &parser);
     };
 
     class Call : public PostfixExpression
     {
     public:
-        std::vector<std::unique_ptr<Expression>> arguments = {};
+        Call() : PostfixExpression(Kind::Call) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::Call; }
 
-        std::unique_ptr<Token> tk_arguments_left = nullptr;
-        std::unique_ptr<Token> tk_arguments_right = nullptr;
-        std::vector<std::unique_ptr<Token>> tk_comma = {};
-        std::unique_ptr<Token> tk_type_call = nullptr;
+        NodeList<Expression *> arguments;
 
-        static std::unique_ptr<Call> Parse(std::shared_ptr<LuaParser> parser);
+        TokenRef tk_arguments_left;
+        TokenRef tk_arguments_right;
+        NodeList<TokenRef> tk_comma;
+        TokenRef tk_type_call;
     };
 
     class PostfixOperator : public PostfixExpression
     {
     public:
-        std::unique_ptr<Token> op;
-        static std::unique_ptr<PostfixOperator> Parse(std::shared_ptr<LuaParser> parser);
+        PostfixOperator() : PostfixExpression(Kind::PostfixOperator) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::PostfixOperator; }
+
+        TokenRef op;
+        static PostfixOperator *Parse(LuaParser &parser);
     };
 
     class IndexExpression : public PostfixExpression
     {
     public:
-        std::unique_ptr<Expression> index = nullptr;
+        IndexExpression() : PostfixExpression(Kind::IndexExpression) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::IndexExpression; }
 
-        std::unique_ptr<Token> tk_left_bracket = nullptr;
-        std::unique_ptr<Token> tk_right_bracket = nullptr;
+        Expression *index = nullptr;
 
-        static std::unique_ptr<IndexExpression> Parse(std::shared_ptr<LuaParser> parser);
+        TokenRef tk_left_bracket;
+        TokenRef tk_right_bracket;
     };
 
     class TypeCast : public PostfixExpression
     {
     public:
-        std::unique_ptr<Expression> expression;
-        std::unique_ptr<Token> tk_operator = nullptr;
+        TypeCast() : PostfixExpression(Kind::TypeCast) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::TypeCast; }
 
-        static std::unique_ptr<TypeCast> Parse(std::shared_ptr<LuaParser> parser);
+        Expression *expression = nullptr;
+        TokenRef tk_operator;
     };
 };
 
 class Atomic : public ValueExpression
 {
 public:
-    std::unique_ptr<Token> value;
+    Atomic() : ValueExpression(Kind::Atomic) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::Atomic; }
+
+    TokenRef value;
     LuaParser::TokenType token_type;
-    static std::unique_ptr<Atomic> Parse(std::shared_ptr<LuaParser> parser);
+    static Atomic *Parse(LuaParser &parser);
+    // a name or ... with an optional : type annotation, which is kept in ParseStorage
+    // nullptr when there is none, which is reported
+    static Atomic *ParseIdentifier(LuaParser &parser);
 };
 
 class Table : public ValueExpression
 {
 public:
+    Table() : ValueExpression(Kind::Table) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::Table; }
+
     class Child : public Expression
     {
+    public:
+        explicit Child(Kind kind) : Expression(kind) {}
+        static constexpr bool IsKind(Kind kind) { return kind >= Kind::TableIdentifierKeyValue && kind <= Kind::TableIndexValue; }
     };
 
     class IdentifierKeyValue : public Child
     {
     public:
-        std::unique_ptr<Token> key = nullptr;
-        std::unique_ptr<Expression> val = nullptr;
+        IdentifierKeyValue() : Child(Kind::TableIdentifierKeyValue) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::TableIdentifierKeyValue; }
 
-        std::unique_ptr<Token> tk_equal = nullptr;
+        TokenRef key;
+        Expression *val = nullptr;
 
-        static std::unique_ptr<IdentifierKeyValue> Parse(std::shared_ptr<LuaParser> parser);
+        TokenRef tk_equal;
     };
 
     class ExpressionKeyValue : public Child
     {
     public:
-        std::unique_ptr<Expression> key = nullptr;
-        std::unique_ptr<Expression> val = nullptr;
+        ExpressionKeyValue() : Child(Kind::TableExpressionKeyValue) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::TableExpressionKeyValue; }
 
-        std::unique_ptr<Token> tk_equal = nullptr;
-        std::unique_ptr<Token> tk_left_bracket = nullptr;
-        std::unique_ptr<Token> tk_right_bracket = nullptr;
+        Expression *key = nullptr;
+        Expression *val = nullptr;
 
-        static std::unique_ptr<ExpressionKeyValue> Parse(std::shared_ptr<LuaParser> parser);
+        TokenRef tk_equal;
+        TokenRef tk_left_bracket;
+        TokenRef tk_right_bracket;
     };
 
     class IndexValue : public Child
     {
     public:
-        uint64_t key = 0;
-        std::unique_ptr<Expression> val = nullptr;
+        IndexValue() : Child(Kind::TableIndexValue) {}
+        static constexpr bool IsKind(Kind kind) { return kind == Kind::TableIndexValue; }
 
-        static std::unique_ptr<IndexValue> Parse(std::shared_ptr<LuaParser> parser);
+        uint64_t key = 0;
+        Expression *val = nullptr;
     };
 
-    std::vector<std::unique_ptr<Child>> children = {};
-
-    std::unique_ptr<Token> tk_left_bracket = nullptr;
-    std::unique_ptr<Token> tk_right_bracket = nullptr;
-    std::vector<std::unique_ptr<Token>> tk_separators = {};
+    NodeList<Child *> children;
 
-    static std::unique_ptr<Table> Parse(std::shared_ptr<LuaParser> parser);
+    TokenRef tk_left_bracket;
+    TokenRef tk_right_bracket;
+    NodeList<TokenRef> tk_separators;
 };
 
 class PrefixOperator : public ValueExpression
 {
 public:
-    std::unique_ptr<Token> op;
-    std::unique_ptr<Expression> right;
+    PrefixOperator() : ValueExpression(Kind::PrefixOperator) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::PrefixOperator; }
 
-    static std::unique_ptr<PrefixOperator> Parse(std::shared_ptr<LuaParser> parser);
+    TokenRef op;
+    Expression *right = nullptr;
 };
 
 class BinaryOperator : public ValueExpression
 {
 public:
-    std::unique_ptr<Token> op;
-    std::unique_ptr<Expression> left;
-    std::unique_ptr<Expression> right;
+    BinaryOperator() : ValueExpression(Kind::BinaryOperator) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::BinaryOperator; }
 
-    static std::unique_ptr<BinaryOperator> Parse(std::shared_ptr<LuaParser> parser);
+    TokenRef op;
+    Expression *left = nullptr;
+    Expression *right = nullptr;
 };
 
 class Function : public ValueExpression
 {
 public:
-    std::unique_ptr<Token> tk_function = nullptr;
-    std::unique_ptr<Token> tk_arguments_left = nullptr;
-    std::vector<std::unique_ptr<Token>> tk_argument_separators = {};
-    std::vector<std::unique_ptr<Expression>> arguments;
-    std::unique_ptr<Token> tk_arguments_right = nullptr;
-    std::vector<std::unique_ptr<Token>> tk_return_separators = {};
-    std::unique_ptr<Token> tk_end = nullptr;
-
-    static std::unique_ptr<Function> Parse(std::shared_ptr<LuaParser> parser);
+    Function() : ValueExpression(Kind::Function) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::Function; }
+
+    TokenRef tk_function;
+    TokenRef tk_arguments_left;
+    NodeList<TokenRef> tk_argument_separators;
+    NodeList<Atomic *> arguments;
+    TokenRef tk_arguments_right;
+    // the types after ): in the typesystem, the colon is kept in ParseStorage
+    NodeList<Expression *> return_types;
+    NodeList<TokenRef> tk_return_separators;
+    NodeList<Statement *> statements;
+    TokenRef tk_end;
+
+    static Function *Parse(LuaParser &parser);
+    // everything from the arguments to end, for function statements that read the function token themselves
+    static void ParseBody(LuaParser &parser, Function *node);
+};
+
+// stands in for an expression that is missing, the diagnostic about it is in ParseStorage
+class ErrorExpression : public Expression
+{
+public:
+    ErrorExpression() : Expression(Kind::ErrorExpression) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::ErrorExpression; }
+
+    // the token found where the expression should have started, it is not part of the node
+    TokenRef token;
+
+    // reports code at the next token and returns the node to use instead of the expression
+    static ErrorExpression *Missing(LuaParser &parser, ParserDiagnostic::Code code);
 };
@@ -0,0 +1,551 @@
+#include "./Statement.hpp"
+
+static Expression *ExpectExpression(LuaParser &parser)
+{
+    auto node = ValueExpression::Parse(parser);
+
+    if (!node)
+        return ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedExpression);
+
+    return node;
+}
+
+// the token before the next one, for spans of code that was read already
+static TokenRef LastRead(LuaParser &parser)
+{
+    return TokenRef{parser.PeekRef().index - 1};
+}
+
+// one or more expressions separated by commas
+static void ParseExpressionList(LuaParser &parser, NodeList<Expression *> &expressions, NodeList<TokenRef> &separators)
+{
+    expressions.push_back(parser.GetArena(), ExpectExpression(parser));
+
+    while (parser.IsValue(Atom::Comma))
+    {
+        separators.push_back(parser.GetArena(), parser.ReadToken());
+        expressions.push_back(parser.GetArena(), ExpectExpression(parser));
+    }
+}
+
+// missing identifiers are reported and left out
+static void ParseIdentifierList(LuaParser &parser, NodeList<Atomic *> &identifiers, NodeList<TokenRef> &separators)
+{
+    while (true)
+    {
+        if (auto identifier = Atomic::ParseIdentifier(parser))
+            identifiers.push_back(parser.GetArena(), identifier);
+
+        if (!parser.IsValue(Atom::Comma))
+            break;
+
+        separators.push_back(parser.GetArena(), parser.ReadToken());
+    }
+}
+
+// a.b.c or a.b:c
+static Expression *ParseFunctionName(LuaParser &parser)
+{
+    Expression *name = parser.IsType(Token::Kind::Letter) ? Atomic::Parse(parser) : nullptr;
+
+    if (!name)
+        return ErrorExpression::Missing(parser, ParserDiagnostic::ExpectedFunctionName);
+
+    while (auto index = ValueExpression::Index::Parse(parser))
+    {
+        index->left = name;
+        name = index;
+    }
+
+    if (auto self_call = ValueExpression::SelfCall::Parse(parser))
+    {
+        self_call->left = name;
+        name = self_call;
+    }
+
+    return name;
+}
+
+static bool IsAssignable(LuaParser &parser, Expression *node)
+{
+    if (auto atomic = NodeCast<Atomic>(node))
+        return parser.GetToken(atomic->value).kind == Token::Kind::Letter;
+
+    return NodeCast<ValueExpression::Index>(node) || NodeCast<ValueExpression::IndexExpression>(node);
+}
+
+// where the statement after broken code can start or the block it is in can end
+static bool IsStatementBoundary(LuaParser &parser)
+{
+    auto token = parser.PeekToken();
+
+    if (token->kind == Token::Kind::EndOfFile)
+        return true;
+
+    switch (token->atom)
+    {
+    case Atom::End:
+    case Atom::Else:
+    case Atom::ElseIf:
+    case Atom::Until:
+    case Atom::Local:
+    case Atom::Function:
+    case Atom::If:
+    case Atom::For:
+    case Atom::While:
+    case Atom::Repeat:
+    case Atom::Do:
+    case Atom::Return:
+    case Atom::Break:
+    case Atom::Continue:
+    case Atom::Semicolon:
+    case Atom::DoubleColon:
+        return true;
+    default:
+        return false;
+    }
+}
+
+ErrorStatement *ErrorStatement::Parse(LuaParser &parser, ParserDiagnostic::Code code)
+{
+    auto node = parser.New<ErrorStatement>();
+    parser.StartNode(node);
+    node->tk_start = parser.ReadToken();
+    node->tk_stop = node->tk_start;
+
+    while (!IsStatementBoundary(parser))
+        node->tk_stop = parser.ReadToken();
+
+    parser.Report(code, node->tk_start, node->tk_stop);
+    parser.EndNode(node);
+
+    return node;
+}
+
+EndOfFileStatement *EndOfFileStatement::Parse(LuaParser &parser)
+{
+    if (!parser.IsType(Token::Kind::EndOfFile))
+    {
+        parser.Report(ParserDiagnostic::ExpectedEndOfFile, parser.PeekRef(), parser.PeekRef());
+        parser.SkipToEndOfFile();
+    }
+
+    auto node = parser.New<EndOfFileStatement>();
+    parser.StartNode(node);
+    node->tk_main = parser.ReadToken();
+    parser.EndNode(node);
+
+    return node;
+}
+
+LocalAssignmentStatement *LocalAssignmentStatement::Parse(LuaParser &parser)
+{
+    auto environment = parser.environment;
+    auto node = parser.New<LocalAssignmentStatement>();
+    node->tk_local = parser.ExpectValue(Atom::Local);
+
+    // local type = 1 declares a variable called type
+    if (parser.IsValue(Atom::Type) && parser.IsType(Token::Kind::Letter, 1))
+    {
+        node->tk_type = parser.ReadToken();
+        parser.environment = ParserNode::Typesystem;
+    }
+
+    parser.StartNode(node);
+    ParseIdentifierList(parser, node->left, node->tk_left_separators);
+
+    if (parser.IsValue(Atom::Assign))
+    {
+        node->tk_equal = parser.ReadToken();
+        ParseExpressionList(parser, node->right, node->tk_right_separators);
+    }
+
+    parser.environment = environment;
+    parser.EndNode(node);
+
+    return node;
+}
+
+// statements that start with an expression, type a = 1 included
+static Statement *ParseAssignmentOrExpression(LuaParser &parser)
+{
+    auto environment = parser.environment;
+    auto start = parser.PeekRef();
+    TokenRef tk_type;
+
+    if (parser.IsValue(Atom::Type) && parser.IsType(Token::Kind::Letter, 1))
+    {
+        tk_type = parser.ReadToken();
+        parser.environment = ParserNode::Typesystem;
+    }
+
+    auto expression = ValueExpression::Parse(parser);
+
+    if (!expression)
+    {
+        parser.environment = environment;
+        return ErrorStatement::Parse(parser, ParserDiagnostic::ExpectedAssignmentOrCall);
+    }
+
+    if (tk_type || parser.IsValue(Atom::Assign) || parser.IsValue(Atom::Comma))
+    {
+        auto node = parser.New<AssignmentStatement>();
+        parser.StartNode(node);
+        node->tk_type = tk_type;
+        node->left.push_back(parser.GetArena(), expression);
+
+        while (parser.IsValue(Atom::Comma))
+        {
+            node->tk_left_separators.push_back(parser.GetArena(), parser.ReadToken());
+            node->left.push_back(parser.GetArena(), ExpectExpression(parser));
+        }
+
+        for (auto left : node->left)
+        {
+            if (!IsAssignable(parser, left))
+            {
+                parser.Report(ParserDiagnostic::NotAssignable, start, LastRead(parser));
+                break;
+            }
+        }
+
+        node->tk_equal = parser.ExpectValue(Atom::Assign);
+        ParseExpressionList(parser, node->right, node->tk_right_separators);
+
+        parser.environment = environment;
+        parser.EndNode(node);
+
+        return node;
+    }
+
+    if (!NodeCast<ValueExpression::Call>(expression) && !NodeCast<ValueExpression::PostfixOperator>(expression))
+    {
+        auto node = parser.New<ErrorStatement>();
+        parser.StartNode(node);
+        node->value = expression;
+        node->tk_start = start;
+        node->tk_stop = LastRead(parser);
+        parser.Report(ParserDiagnostic::ExpectedAssignmentOrCall, node->tk_start, node->tk_stop);
+        parser.EndNode(node);
+
+        return node;
+    }
+
+    auto node = parser.New<ExpressionStatement>();
+    parser.StartNode(node);
+    node->value = expression;
+    parser.EndNode(node);
+
+    return node;
+}
+
+IfStatement *IfStatement::Parse(LuaParser &parser)
+{
+    auto node = parser.New<IfStatement>();
+    parser.StartNode(node);
+
+    do
+    {
+        node->tk_if.push_back(parser.GetArena(), parser.ReadToken());
+        node->conditions.push_back(parser.GetArena(), ExpectExpression(parser));
+        node->tk_then.push_back(parser.GetArena(), parser.ExpectValue(Atom::Then));
+        node->blocks.push_back(parser.GetArena(), Statement::ParseBlock(parser));
+    } while (parser.IsValue(Atom::ElseIf));
+
+    if (parser.IsValue(Atom::Else))
+    {
+        node->tk_if.push_back(parser.GetArena(), parser.ReadToken());
+        node->blocks.push_back(parser.GetArena(), Statement::ParseBlock(parser));
+    }
+
+    node->tk_end = parser.ExpectValue(Atom::End);
+    parser.EndNode(node);
+
+    return node;
+}
+
+static Statement *ParseFor(LuaParser &parser)
+{
+    if (parser.IsType(Token::Kind::Letter, 1) && parser.IsValue(Atom::Assign, 2))
+    {
+        auto node = parser.New<NumericForStatement>();
+        parser.StartNode(node);
+        node->tk_for = parser.ReadToken();
+        node->identifier = Atomic::ParseIdentifier(parser);
+        node->tk_equal = parser.ExpectValue(Atom::Assign);
+        node->start = ExpectExpression(parser);
+        node->tk_separators.push_back(parser.GetArena(), parser.ExpectValue(Atom::Comma));
+        node->stop = ExpectExpression(parser);
+
+        if (parser.IsValue(Atom::Comma))
+        {
+            node->tk_separators.push_back(parser.GetArena(), parser.ReadToken());
+            node->step = ExpectExpression(parser);
+        }
+
+        node->tk_do = parser.ExpectValue(Atom::Do);
+        node->statements = Statement::ParseBlock(parser);
+        node->tk_end = parser.ExpectValue(Atom::End);
+        parser.EndNode(node);
+
+        return node;
+    }
+
+    auto node = parser.New<GenericForStatement>();
+    parser.StartNode(node);
+    node->tk_for = parser.ReadToken();
+    ParseIdentifierList(parser, node->identifiers, node->tk_identifier_separators);
+    node->tk_in = parser.ExpectValue(Atom::In);
+    ParseExpressionList(parser, node->expressions, node->tk_expression_separators);
+    node->tk_do = parser.ExpectValue(Atom::Do);
+    node->statements = Statement::ParseBlock(parser);
+    node->tk_end = parser.ExpectValue(Atom::End);
+    parser.EndNode(node);
+
+    return node;
+}
+
+WhileStatement *WhileStatement::Parse(LuaParser &parser)
+{
+    auto node = parser.New<WhileStatement>();
+    parser.StartNode(node);
+    node->tk_while = parser.ReadToken();
+    node->condition = ExpectExpression(parser);
+    node->tk_do = parser.ExpectValue(Atom::Do);
+    node->statements = Statement::ParseBlock(parser);
+    node->tk_end = parser.ExpectValue(Atom::End);
+    parser.EndNode(node);
+
+    return node;
+}
+
+RepeatStatement *RepeatStatement::Parse(LuaParser &parser)
+{
+    auto node = parser.New<RepeatStatement>();
+    parser.StartNode(node);
+    node->tk_repeat = parser.ReadToken();
+    node->statements = Statement::ParseBlock(parser);
+    node->tk_until = parser.ExpectValue(Atom::Until);
+    node->condition = ExpectExpression(parser);
+    parser.EndNode(node);
+
+    return node;
+}
+
+DoStatement *DoStatement::Parse(LuaParser &parser)
+{
+    auto node = parser.New<DoStatement>();
+    parser.StartNode(node);
+    node->tk_do = parser.ReadToken();
+    node->statements = Statement::ParseBlock(parser);
+    node->tk_end = parser.ExpectValue(Atom::End);
+    parser.EndNode(node);
+
+    return node;
+}
+
+ReturnStatement *ReturnStatement::Parse(LuaParser &parser)
+{
+    auto node = parser.New<ReturnStatement>();
+    parser.StartNode(node);
+    node->tk_return = parser.ReadToken();
+
+    if (auto first = ValueExpression::Parse(parser))
+    {
+        node->expressions.push_back(parser.GetArena(), first);
+
+        while (parser.IsValue(Atom::Comma))
+        {
+            node->tk_separators.push_back(parser.GetArena(), parser.ReadToken());
+            node->expressions.push_back(parser.GetArena(), ExpectExpression(parser));
+        }
+    }
+
+    parser.EndNode(node);
+
+    return node;
+}
+
+FunctionStatement *FunctionStatement::Parse(LuaParser &parser)
+{
+    auto environment = parser.environment;
+    auto node = parser.New<FunctionStatement>();
+
+    if (parser.IsValue(Atom::Type))
+    {
+        node->tk_type = parser.ReadToken();
+        parser.environment = ParserNode::Typesystem;
+    }
+
+    parser.StartNode(node);
+
+    node->function = parser.New<Function>();
+    parser.StartNode(node->function);
+    node->function->tk_function = parser.ExpectValue(Atom::Function);
+    node->name = ParseFunctionName(parser);
+    Function::ParseBody(parser, node->function);
+
+    parser.environment = environment;
+    parser.EndNode(node);
+
+    return node;
+}
+
+LocalFunctionStatement *LocalFunctionStatement::Parse(LuaParser &parser)
+{
+    auto environment = parser.environment;
+    auto node = parser.New<LocalFunctionStatement>();
+    node->tk_local = parser.ExpectValue(Atom::Local);
+
+    if (parser.IsValue(Atom::Type))
+    {
+        node->tk_type = parser.ReadToken();
+        parser.environment = ParserNode::Typesystem;
+    }
+
+    parser.StartNode(node);
+
+    node->function = parser.New<Function>();
+    parser.StartNode(node->function);
+    node->function->tk_function = parser.ExpectValue(Atom::Function);
+    node->identifier = parser.IsType(Token::Kind::Letter) ? Atomic::Parse(parser) : nullptr;
+
+    if (!node->identifier)
+        parser.Report(ParserDiagnostic::ExpectedFunctionName, parser.PeekRef(), parser.PeekRef());
+
+    Function::ParseBody(parser, node->function);
+
+    parser.environment = environment;
+    parser.EndNode(node);
+
+    return node;
+}
+
+// statements that are a single token
+template <typename T>
+static T *ParseKeyword(LuaParser &parser, TokenRef T::*token)
+{
+    auto node = parser.New<T>();
+    parser.StartNode(node);
+    node->*token = parser.ReadToken();
+    parser.EndNode(node);
+
+    return node;
+}
+
+Statement *Statement::Parse(LuaParser &parser)
+{
+    auto token = parser.PeekToken();
+
+    switch (token->kind)
+    {
+    case Token::Kind::EndOfFile:
+        return nullptr;
+    case Token::Kind::AnalyzerDebugCode:
+        return ParseKeyword(parser, &AnalyzerDebugCodeStatement::tk_main);
+    case Token::Kind::ParserDebugCode:
+        return ParseKeyword(parser, &ParserDebugCodeStatement::tk_main);
+    default:
+        break;
+    }
+
+    switch (token->atom)
+    {
+    case Atom::End:
+    case Atom::Else:
+    case Atom::ElseIf:
+    case Atom::Until:
+        return nullptr;
+    case Atom::Return:
+        return ReturnStatement::Parse(parser);
+    case Atom::Break:
+        return ParseKeyword(parser, &BreakStatement::tk_break);
+    case Atom::Continue:
+        return ParseKeyword(parser, &ContinueStatement::tk_continue);
+    case Atom::Semicolon:
+        return ParseKeyword(parser, &SemicolonStatement::tk_main);
+    case Atom::Do:
+        return DoStatement::Parse(parser);
+    case Atom::While:
+        return WhileStatement::Parse(parser);
+    case Atom::Repeat:
+        return RepeatStatement::Parse(parser);
+    case Atom::If:
+        return IfStatement::Parse(parser);
+    case Atom::For:
+        return ParseFor(parser);
+    case Atom::Function:
+        return FunctionStatement::Parse(parser);
+    case Atom::Local:
+        if (parser.IsValue(Atom::Function, 1) || (parser.IsValue(Atom::Type, 1) && parser.IsValue(Atom::Function, 2)))
+            return LocalFunctionStatement::Parse(parser);
+
+        return LocalAssignmentStatement::Parse(parser);
+    case Atom::Type:
+        if (parser.IsValue(Atom::Function, 1))
+            return FunctionStatement::Parse(parser);
+
+        break;
+    case Atom::Goto:
+        if (parser.IsType(Token::Kind::Letter, 1))
+        {
+            auto node = parser.New<GotoStatement>();
+            parser.StartNode(node);
+            node->tk_goto = parser.ReadToken();
+            node->identifier = parser.ReadToken();
+            parser.EndNode(node);
+
+            return node;
+        }
+
+        break;
+    case Atom::DoubleColon:
+    {
+        auto node = parser.New<GotoLabelStatement>();
+        parser.StartNode(node);
+        node->tk_left = parser.ReadToken();
+        node->identifier = parser.ExpectType(Token::Kind::Letter);
+        node->tk_right = parser.ExpectValue(Atom::DoubleColon);
+        parser.EndNode(node);
+
+        return node;
+    }
+    default:
+        break;
+    }
+
+    return ParseAssignmentOrExpression(parser);
+}
+
+NodeList<Statement *> Statement::ParseBlock(LuaParser &parser)
+{
+    NodeList<Statement *> statements;
+
+    // the blocks that are open are closed at the end of the file
+    if (parser.block_depth >= parser.max_block_depth)
+    {
+        parser.Report(ParserDiagnostic::BlockTooDeep, parser.PeekRef(), parser.PeekRef());
+        parser.SkipToEndOfFile();
+        return statements;
+    }
+
+    parser.block_depth++;
+
+    while (auto statement = Statement::Parse(parser))
+        statements.push_back(parser.GetArena(), statement);
+
+    parser.block_depth--;
+
+    return statements;
+}
+
+Statement *Statement::ParseTopLevel(LuaParser &parser)
+{
+    if (auto statement = Statement::Parse(parser))
+        return statement;
+
+    if (parser.IsType(Token::Kind::EndOfFile))
+        return nullptr;
+
+    return ErrorStatement::Parse(parser, ParserDiagnostic::ExpectedEndOfFile);
+}
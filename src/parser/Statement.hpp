@@ -4,19 +4,334 @@
 #include "./ParserNode.hpp"
 #include "./PrimaryExpression.hpp"
 
-class StatementNode : public ParserNode
+class Statement : public ParserNode
 {
+public:
+    explicit Statement(Kind kind) : ParserNode(kind) {}
+    static constexpr bool IsKind(Kind kind) { return kind >= Kind::EndOfFileStatement && kind <= Kind::ErrorStatement; }
+
+    // nullptr at the end of the file and at end, else, elseif and until, which only the enclosing statement reads
+    static Statement *Parse(LuaParser &parser);
+    // statements up to the end of the block, deeper blocks than LuaParser::max_block_depth are an error
+    static NodeList<Statement *> ParseBlock(LuaParser &parser);
+    // like Parse, but a stray end, else, elseif or until becomes an ErrorStatement so the rest of the file is parsed
+    static Statement *ParseTopLevel(LuaParser &parser);
+};
+
+// the whole file, its last statement is always an EndOfFileStatement
+class Root : public ParserNode
+{
+public:
+    Root() : ParserNode(Kind::Root) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::Root; }
+
+    NodeList<Statement *> statements;
+};
+
+class EndOfFileStatement : public Statement
+{
+public:
+    EndOfFileStatement() : Statement(Kind::EndOfFileStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::EndOfFileStatement; }
+
+    TokenRef tk_main;
+
+    static EndOfFileStatement *Parse(LuaParser &parser);
+};
+
+// a § line, the lua code is the rest of the token
+class AnalyzerDebugCodeStatement : public Statement
+{
+public:
+    AnalyzerDebugCodeStatement() : Statement(Kind::AnalyzerDebugCodeStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::AnalyzerDebugCodeStatement; }
+
+    TokenRef tk_main;
+};
+
+// a £ line
+class ParserDebugCodeStatement : public Statement
+{
+public:
+    ParserDebugCodeStatement() : Statement(Kind::ParserDebugCodeStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::ParserDebugCodeStatement; }
+
+    TokenRef tk_main;
+};
+
+// local a, b = 1, 2 and local type a = number, which is parsed in the typesystem
+class LocalAssignmentStatement : public Statement
+{
+public:
+    LocalAssignmentStatement() : Statement(Kind::LocalAssignmentStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::LocalAssignmentStatement; }
+
+    // identifiers, their type annotations are in ParseStorage
+    NodeList<Atomic *> left;
+    NodeList<Expression *> right;
+
+    TokenRef tk_local;
+    TokenRef tk_type;
+    NodeList<TokenRef> tk_left_separators;
+    TokenRef tk_equal;
+    NodeList<TokenRef> tk_right_separators;
+
+    static LocalAssignmentStatement *Parse(LuaParser &parser);
+};
+
+// a.b, c[1] = 1, 2 and type a = number
+class AssignmentStatement : public Statement
+{
+public:
+    AssignmentStatement() : Statement(Kind::AssignmentStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::AssignmentStatement; }
+
+    NodeList<Expression *> left;
+    NodeList<Expression *> right;
+
+    TokenRef tk_type;
+    NodeList<TokenRef> tk_left_separators;
+    TokenRef tk_equal;
+    NodeList<TokenRef> tk_right_separators;
 };
 
-class EndOfFile : public StatementNode
+// a call or a postfix operator such as a++ on its own
+class ExpressionStatement : public Statement
 {
-    std::unique_ptr<Token> tk_main;
+public:
+    ExpressionStatement() : Statement(Kind::ExpressionStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::ExpressionStatement; }
+
+    Expression *value = nullptr;
+};
+
+class IfStatement : public Statement
+{
+public:
+    IfStatement() : Statement(Kind::IfStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::IfStatement; }
+
+    // one per if and elseif
+    NodeList<Expression *> conditions;
+    // one per condition, followed by the else block if there is one
+    NodeList<NodeList<Statement *>> blocks;
+
+    // if, every elseif and else in order
+    NodeList<TokenRef> tk_if;
+    NodeList<TokenRef> tk_then;
+    TokenRef tk_end;
+
+    static IfStatement *Parse(LuaParser &parser);
 };
 
-class AnalyzerDebugCode : public StatementNode
+class NumericForStatement : public Statement
 {
-    std::unique_ptr<Token> tk_main;
-    Atomic *lua_code;
+public:
+    NumericForStatement() : Statement(Kind::NumericForStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::NumericForStatement; }
+
+    Atomic *identifier = nullptr;
+    Expression *start = nullptr;
+    Expression *stop = nullptr;
+    // nullptr unless given
+    Expression *step = nullptr;
+    NodeList<Statement *> statements;
+
+    TokenRef tk_for;
+    TokenRef tk_equal;
+    NodeList<TokenRef> tk_separators;
+    TokenRef tk_do;
+    TokenRef tk_end;
 };
 
-// OPERATORS
+class GenericForStatement : public Statement
+{
+public:
+    GenericForStatement() : Statement(Kind::GenericForStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::GenericForStatement; }
+
+    NodeList<Atomic *> identifiers;
+    NodeList<Expression *> expressions;
+    NodeList<Statement *> statements;
+
+    TokenRef tk_for;
+    NodeList<TokenRef> tk_identifier_separators;
+    TokenRef tk_in;
+    NodeList<TokenRef> tk_expression_separators;
+    TokenRef tk_do;
+    TokenRef tk_end;
+};
+
+class WhileStatement : public Statement
+{
+public:
+    WhileStatement() : Statement(Kind::WhileStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::WhileStatement; }
+
+    Expression *condition = nullptr;
+    NodeList<Statement *> statements;
+
+    TokenRef tk_while;
+    TokenRef tk_do;
+    TokenRef tk_end;
+
+    static WhileStatement *Parse(LuaParser &parser);
+};
+
+class RepeatStatement : public Statement
+{
+public:
+    RepeatStatement() : Statement(Kind::RepeatStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::RepeatStatement; }
+
+    NodeList<Statement *> statements;
+    Expression *condition = nullptr;
+
+    TokenRef tk_repeat;
+    TokenRef tk_until;
+
+    static RepeatStatement *Parse(LuaParser &parser);
+};
+
+class DoStatement : public Statement
+{
+public:
+    DoStatement() : Statement(Kind::DoStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::DoStatement; }
+
+    NodeList<Statement *> statements;
+
+    TokenRef tk_do;
+    TokenRef tk_end;
+
+    static DoStatement *Parse(LuaParser &parser);
+};
+
+class ReturnStatement : public Statement
+{
+public:
+    ReturnStatement() : Statement(Kind::ReturnStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::ReturnStatement; }
+
+    NodeList<Expression *> expressions;
+
+    TokenRef tk_return;
+    NodeList<TokenRef> tk_separators;
+
+    static ReturnStatement *Parse(LuaParser &parser);
+};
+
+class BreakStatement : public Statement
+{
+public:
+    BreakStatement() : Statement(Kind::BreakStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::BreakStatement; }
+
+    TokenRef tk_break;
+};
+
+class ContinueStatement : public Statement
+{
+public:
+    ContinueStatement() : Statement(Kind::ContinueStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::ContinueStatement; }
+
+    TokenRef tk_continue;
+};
+
+class GotoStatement : public Statement
+{
+public:
+    GotoStatement() : Statement(Kind::GotoStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::GotoStatement; }
+
+    TokenRef tk_goto;
+    TokenRef identifier;
+};
+
+// ::name::
+class GotoLabelStatement : public Statement
+{
+public:
+    GotoLabelStatement() : Statement(Kind::GotoLabelStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::GotoLabelStatement; }
+
+    TokenRef tk_left;
+    TokenRef identifier;
+    TokenRef tk_right;
+};
+
+class SemicolonStatement : public Statement
+{
+public:
+    SemicolonStatement() : Statement(Kind::SemicolonStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::SemicolonStatement; }
+
+    TokenRef tk_main;
+};
+
+// function a.b:c() end and type function a() end, the function token is in the function node
+class FunctionStatement : public Statement
+{
+public:
+    FunctionStatement() : Statement(Kind::FunctionStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::FunctionStatement; }
+
+    // an identifier, followed by indexes and at most one self call
+    Expression *name = nullptr;
+    Function *function = nullptr;
+
+    TokenRef tk_type;
+
+    static FunctionStatement *Parse(LuaParser &parser);
+};
+
+// local function a() end and local type function a() end
+class LocalFunctionStatement : public Statement
+{
+public:
+    LocalFunctionStatement() : Statement(Kind::LocalFunctionStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::LocalFunctionStatement; }
+
+    // nullptr when the name is missing
+    Atomic *identifier = nullptr;
+    Function *function = nullptr;
+
+    TokenRef tk_local;
+    TokenRef tk_type;
+
+    static LocalFunctionStatement *Parse(LuaParser &parser);
+};
+
+// code from tk_start to tk_stop that is not a statement
+class ErrorStatement : public Statement
+{
+public:
+    ErrorStatement() : Statement(Kind::ErrorStatement) {}
+    static constexpr bool IsKind(Kind kind) { return kind == Kind::ErrorStatement; }
+
+    // what the tokens parsed as, if they started with an expression that is not a statement
+    Expression *value = nullptr;
+
+    TokenRef tk_start;
+    TokenRef tk_stop;
+
+    // reports code at the next token and skips it along with everything up to the next statement keyword or block end
+    static ErrorStatement *Parse(LuaParser &parser, ParserDiagnostic::Code code);
+};
+
+// calls visitor with the node cast to its concrete type
+template <typename Visitor>
+inline decltype(auto) VisitNode(ParserNode *node, Visitor &&visitor)
+{
+    switch (node->kind)
+    {
+#define X(kind, type)             \
+    case ParserNode::Kind::kind: \
+        return visitor(static_cast<type *>(node));
+        PARSER_NODE_LIST(X)
+#undef X
+    }
+
+    __builtin_unreachable();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "../lexer/Token.hpp"
+
+// position of a token in a TokenStore, nodes hold these instead of pointers to tokens
+struct TokenRef
+{
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = NONE;
+
+    explicit operator bool() const { return index != NONE; }
+    bool operator==(const TokenRef &) const = default;
+};
+
+// every token of a parse in source order
+// tokens are only ever appended, so a TokenRef stays valid for as long as the store
+class TokenStore
+{
+public:
+    const Token &operator[](TokenRef ref) const
+    {
+        assert(ref.index < tokens.size());
+        return tokens[ref.index];
+    }
+    const Token &Get(size_t index) const { return tokens[index]; }
+    size_t Size() const { return tokens.size(); }
+    bool Empty() const { return tokens.empty(); }
+    const Token &Back() const { return tokens.back(); }
+
+    void Reserve(size_t size) { tokens.reserve(size); }
+    // keeps the capacity for the tokens of the next file
+    void Clear() { tokens.clear(); }
+    TokenRef Add(Token &&token)
+    {
+        assert(tokens.size() < TokenRef::NONE);
+        tokens.push_back(std::move(token));
+        return TokenRef{static_cast<uint32_t>(tokens.size() - 1)};
+    }
+
+    std::vector<Token>::const_iterator begin() const { return tokens.begin(); }
+    std::vector<Token>::const_iterator end() const { return tokens.end(); }
+
+private:
+    std::vector<Token> tokens;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include "../lexer/Token.hpp"
+#include "./TokenStore.hpp"
+
+// read position in a TokenStore, which is filled on demand from a token source
+// once the source is exhausted the store ends with an EndOfFile token that is read over and over
+class TokenWindow
+{
+public:
+    // returns nullptr when there are no more tokens
+    using Source = std::function<std::unique_ptr<Token>()>;
+
+    // the store already holds every token
+    explicit TokenWindow(std::shared_ptr<TokenStore> store)
+    {
+        this->store = std::move(store);
+        Finish();
+    }
+
+    TokenWindow(std::shared_ptr<TokenStore> store, Source source)
+    {
+        this->store = std::move(store);
+        this->source = std::move(source);
+    }
+
+    // valid until the store grows, which only happens on a later Peek or Read
+    const Token *Peek(size_t offset = 0)
+    {
+        while (!finished && store->Size() <= head + offset)
+            Pull();
+
+        if (head + offset >= store->Size())
+            return &store->Back();
+
+        return &store->Get(head + offset);
+    }
+
+    TokenRef Read()
+    {
+        Peek();
+
+        auto ref = TokenRef{static_cast<uint32_t>(head)};
+
+        if (head + 1 < store->Size() || !finished)
+            head++;
+
+        return ref;
+    }
+
+    // number of tokens read so far
+    inline size_t GetIndex() { return head; }
+
+    const std::shared_ptr<TokenStore> &GetStore() const { return store; }
+
+private:
+    std::shared_ptr<TokenStore> store;
+    Source source;
+    size_t head = 0;
+    bool finished = false;
+
+    void Pull()
+    {
+        if (source)
+        {
+            if (auto token = source())
+            {
+                auto kind = token->kind;
+                store->Add(std::move(*token));
+
+                if (kind == Token::Kind::EndOfFile)
+                    finished = true;
+
+                return;
+            }
+        }
+
+        Finish();
+    }
+
+    // makes sure the store ends with an EndOfFile token
+    void Finish()
+    {
+        finished = true;
+        source = nullptr;
+
+        if (!store->Empty() && store->Back().kind == Token::Kind::EndOfFile)
+            return;
+
+        auto end_of_file = store->Empty() ? 0 : store->Back().stop;
+        auto token = Token(Token::Kind::EndOfFile);
+        token.start = end_of_file;
+        token.stop = end_of_file;
+        token.index = static_cast<uint32_t>(store->Size());
+        store->Add(std::move(token));
+    }
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+// keywords and symbols known to the syntax, each gets a fixed atom id in this order
+#define ATOM_LIST(X)                         \
+    X(None, "")                              \
+    X(Do, "do")                              \
+    X(End, "end")                            \
+    X(If, "if")                              \
+    X(Then, "then")                          \
+    X(Else, "else")                          \
+    X(ElseIf, "elseif")                      \
+    X(For, "for")                            \
+    X(In, "in")                              \
+    X(While, "while")                        \
+    X(Repeat, "repeat")                      \
+    X(Until, "until")                        \
+    X(Break, "break")                        \
+    X(Return, "return")                      \
+    X(Local, "local")                        \
+    X(Function, "function")                  \
+    X(And, "and")                            \
+    X(Not, "not")                            \
+    X(Or, "or")                              \
+    X(Continue, "continue")                  \
+    X(Import, "import")                      \
+    X(Literal, "literal")                    \
+    X(Mutable, "mutable")                    \
+    X(Nil, "nil")                            \
+    X(True, "true")                          \
+    X(False, "false")                        \
+    X(Supertype, "supertype")                \
+    X(Typeof, "typeof")                      \
+    X(Unique, "unique")                      \
+    X(Expand, "expand")                      \
+    X(Extends, "extends")                    \
+    X(SubsetOf, "subsetof")                  \
+    X(SupersetOf, "supersetof")              \
+    X(As, "as")                              \
+    X(Goto, "goto")                          \
+    X(Type, "type")                          \
+    X(Aeoa, "ÆØÅ")                           \
+    X(AeoaAe, "ÆØÅÆ")                        \
+    X(Ellipsis, "...")                       \
+    X(Comma, ",")                            \
+    X(Semicolon, ";")                        \
+    X(LeftParenthesis, "(")                  \
+    X(RightParenthesis, ")")                 \
+    X(LeftBrace, "{")                        \
+    X(RightBrace, "}")                       \
+    X(LeftBracket, "[")                      \
+    X(RightBracket, "]")                     \
+    X(Assign, "=")                           \
+    X(DoubleColon, "::")                     \
+    X(DoubleQuote, "\"")                     \
+    X(SingleQuote, "'")                      \
+    X(LeftTypeArguments, "<|")               \
+    X(RightTypeArguments, "|>")              \
+    X(Minus, "-")                            \
+    X(Hash, "#")                             \
+    X(Exclamation, "!")                      \
+    X(Tilde, "~")                            \
+    X(Dollar, "$")                           \
+    X(Dot, ".")                              \
+    X(Colon, ":")                            \
+    X(Increment, "++")                       \
+    X(DoublePipe, "||")                      \
+    X(DoubleAmpersand, "&&")                 \
+    X(Less, "<")                             \
+    X(Greater, ">")                          \
+    X(LessEqual, "<=")                       \
+    X(GreaterEqual, ">=")                    \
+    X(NotEqual, "~=")                        \
+    X(Equal, "==")                           \
+    X(ExclamationEqual, "!=")                \
+    X(Pipe, "|")                             \
+    X(Ampersand, "&")                        \
+    X(ShiftLeft, "<<")                       \
+    X(ShiftRight, ">>")                      \
+    X(Concat, "..")                          \
+    X(Plus, "+")                             \
+    X(Star, "*")                             \
+    X(Slash, "/")                            \
+    X(IntegerDivision, "/idiv/")             \
+    X(Percent, "%")                          \
+    X(Caret, "^")
+
+// interned strings are identified by their atom, ids past PredefinedCount are assigned at runtime
+namespace Atom
+{
+#define ATOM_ENUM(name, string) name,
+    enum Id : uint32_t
+    {
+        ATOM_LIST(ATOM_ENUM) PredefinedCount
+    };
+#undef ATOM_ENUM
+}
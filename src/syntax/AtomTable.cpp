@@ -0,0 +1,107 @@
+#include "./AtomTable.hpp"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    struct Table
+    {
+        std::shared_mutex mutex;
+        // a deque never moves its elements, so the views below stay valid
+        std::deque<std::string> storage;
+        std::vector<std::string_view> strings;
+        std::unordered_map<std::string_view, Atom::Id> atoms;
+
+        Table()
+        {
+#define ATOM_STRING(name, string) Add(string);
+            ATOM_LIST(ATOM_STRING)
+#undef ATOM_STRING
+        }
+
+        Atom::Id Add(std::string_view value)
+        {
+            auto atom = static_cast<Atom::Id>(strings.size());
+            auto &stored = storage.emplace_back(value);
+            strings.push_back(stored);
+            atoms.emplace(stored, atom);
+            return atom;
+        }
+    };
+
+    Table &GetTable()
+    {
+        static Table table;
+        return table;
+    }
+}
+
+Atom::Id AtomTable::Intern(std::string_view value)
+{
+    auto &table = GetTable();
+
+    {
+        std::shared_lock lock(table.mutex);
+
+        if (auto found = table.atoms.find(value); found != table.atoms.end())
+            return found->second;
+    }
+
+    std::unique_lock lock(table.mutex);
+
+    // another thread may have added it between the two locks
+    if (auto found = table.atoms.find(value); found != table.atoms.end())
+        return found->second;
+
+    return table.Add(value);
+}
+
+Atom::Id AtomTable::Find(std::string_view value)
+{
+    auto &table = GetTable();
+    std::shared_lock lock(table.mutex);
+
+    if (auto found = table.atoms.find(value); found != table.atoms.end())
+        return found->second;
+
+    return Atom::None;
+}
+
+std::string_view AtomTable::GetString(Atom::Id atom)
+{
+    auto &table = GetTable();
+    std::shared_lock lock(table.mutex);
+
+    return table.strings[atom];
+}
+
+size_t AtomTable::Size()
+{
+    auto &table = GetTable();
+    std::shared_lock lock(table.mutex);
+
+    return table.strings.size();
+}
+
+Atom::Id AtomCache::Intern(std::string_view value)
+{
+    // fnv-1a
+    uint32_t hash = 2166136261u;
+
+    for (auto c : value)
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+
+    auto &entry = entries[hash % entries.size()];
+
+    if (entry.value == value && entry.atom != Atom::None)
+        return entry.atom;
+
+    entry.atom = AtomTable::Intern(value);
+    entry.value = AtomTable::GetString(entry.atom);
+
+    return entry.atom;
+}
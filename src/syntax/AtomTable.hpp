@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+#include "./Atom.hpp"
+
+// process wide string interning, safe to use from several threads
+// interned strings live until the process exits
+namespace AtomTable
+{
+    // returns the atom of value, adding it if it is new
+    Atom::Id Intern(std::string_view value);
+
+    // returns Atom::None if value was never interned
+    Atom::Id Find(std::string_view value);
+
+    std::string_view GetString(Atom::Id atom);
+
+    size_t Size();
+}
+
+// remembers recent atoms so most lookups skip the shared table and its lock
+// not thread safe, each lexer owns one
+class AtomCache
+{
+public:
+    Atom::Id Intern(std::string_view value);
+
+private:
+    struct Entry
+    {
+        // points into the atom table, not into the code
+        std::string_view value;
+        Atom::Id atom = Atom::None;
+    };
+
+    std::array<Entry, 1024> entries = {};
+};
@@ -1,72 +1,110 @@
 
 #include "./BaseSyntax.hpp"
 #include "./CharacterClasses.hpp"
+#include <algorithm>
+#include <cassert>
+
+void BaseSyntax::AddFlag(Atom::Id atom, AtomFlag flag)
+{
+    // the string is missing from ATOM_LIST, release builds skip it like AddTranslations does
+    assert(atom < atom_flags.size());
+
+    if (atom >= atom_flags.size())
+        return;
+
+    atom_flags[atom] |= flag;
+}
+
+void BaseSyntax::AddFlag(const std::vector<std::string> &strings, AtomFlag flag)
+{
+    for (auto &str : strings)
+        AddFlag(AtomTable::Intern(str), flag);
+}
+
+void BaseSyntax::AddBinaryOperator(std::string_view op, uint8_t priority, bool right_associative)
+{
+    auto atom = AtomTable::Intern(op);
+
+    // the first priority given to an operator wins
+    if (HasFlag(atom, AtomFlag::BinaryOperator))
+        return;
+
+    AddFlag(atom, AtomFlag::BinaryOperator);
+
+    auto &info = binary_operators[atom];
+    info.left_priority = right_associative ? priority + 1 : priority;
+    info.right_priority = priority;
+    info.right_associative = right_associative;
+}
 
 void BaseSyntax::AddPrefixOperators(std::vector<std::string> vec)
 {
-    prefix_operators_lookup.insert(vec.begin(), vec.end());
+    AddFlag(vec, AtomFlag::PrefixOperator);
     AddSymbols(vec);
 }
 
 void BaseSyntax::AddPostfixOperators(std::vector<std::string> vec)
 {
-    postfix_operators_lookup.insert(vec.begin(), vec.end());
+    AddFlag(vec, AtomFlag::PostfixOperator);
     AddSymbols(vec);
 }
 
 void BaseSyntax::AddPrimaryBinaryOperators(std::vector<std::string> vec)
 {
-    primary_binary_operators_lookup.insert(vec.begin(), vec.end());
+    AddFlag(vec, AtomFlag::PrimaryBinaryOperator);
     AddSymbols(vec);
 }
 
 void BaseSyntax::AddBinaryOperators(std::vector<std::vector<std::string>> groups)
 {
-    uint8_t priority = 0;
+    for (auto &flags : atom_flags)
+        flags &= static_cast<uint8_t>(~AtomFlag::BinaryOperator);
+
+    // priority 0 is below every operator, ValueExpression::Parse starts there
+    uint8_t priority = 1;
+
     for (auto &operators : groups)
     {
         for (auto &op : operators)
         {
-            if (op.starts_with("R"))
-            {
-                std::string op_ = std::string(op).substr(1);
-
-                binary_operator_info.insert(make_pair(op_, new BinaryOperatorInfo{
-                                                               .left_priority = static_cast<uint8_t>(priority + 1),
-                                                               .right_priority = priority,
-                                                           }));
-
-                AddSymbols({op_});
-            }
-            else
-            {
-                binary_operator_info.insert(make_pair(op, new BinaryOperatorInfo{
-                                                              .left_priority = priority,
-                                                              .right_priority = priority,
-                                                          }));
+            auto right_associative = op.starts_with("R");
+            auto symbol = right_associative ? op.substr(1) : op;
 
-                AddSymbols({op});
-            }
+            AddBinaryOperator(symbol, priority, right_associative);
+            AddSymbols({symbol});
         }
+
         priority++;
     }
 }
 
+void BaseSyntax::SetPrefixOperatorPriority(std::string_view op)
+{
+    auto atom = AtomTable::Intern(op);
+    assert(HasFlag(atom, AtomFlag::BinaryOperator));
+
+    for (size_t i = 0; i < prefix_operators.size(); i++)
+    {
+        if (HasFlag(static_cast<Atom::Id>(i), AtomFlag::PrefixOperator))
+            prefix_operators[i].right_priority = binary_operators[atom].right_priority;
+    }
+}
+
 void BaseSyntax::AddKeywords(std::vector<std::string> vec)
 {
-    keyword_lookup.insert(vec.begin(), vec.end());
+    AddFlag(vec, AtomFlag::Keyword);
     AddSymbols(vec);
 }
 
 void BaseSyntax::AddNonStandardKeywords(std::vector<std::string> vec)
 {
-    non_standard_keyword_lookup.insert(vec.begin(), vec.end());
+    AddFlag(vec, AtomFlag::NonStandardKeyword);
     AddSymbols(vec);
 }
 
 void BaseSyntax::AddKeywordValues(std::vector<std::string> vec)
 {
-    keyword_values_lookup.insert(vec.begin(), vec.end());
+    AddFlag(vec, AtomFlag::KeywordValue);
     AddSymbols(vec);
 }
 
@@ -75,64 +113,71 @@ void BaseSyntax::AddSymbolCharacters(const std::vector<std::string> vec)
     AddSymbols(vec);
 }
 
-void BaseSyntax::AddBinaryOperatorTranslation(std::map<std::string, std::string> map)
+// splits "bit.band(A, B)" into the text around the placeholders, {" bit.band(", ", ", " )"} when both ends are padded
+// the padding keeps the translation from running into the code around the operator
+void BaseSyntax::AddTranslations(std::array<OperatorInfo, Atom::PredefinedCount> &operators, const std::map<std::string, std::string> &map, std::string_view placeholders, bool pad_first, bool pad_last)
 {
-    auto const pattern = std::regex("(.*)A(.*)B(.*)");
-
     for (auto const &[key, val] : map)
     {
-        std::smatch matches;
-        if (std::regex_search(val, matches, pattern))
+        auto atom = AtomTable::Intern(key);
+
+        // not an operator of this syntax, like // which lexes as a comment
+        if (atom >= operators.size())
+            continue;
+
+        auto pattern = std::string_view(val);
+        auto parts = std::vector<std::string>();
+
+        // split from the back like the greedy (.*)A(.*) this replaces, so "A = A + 1" becomes {"A = ", " + 1"}
+        for (auto placeholder = placeholders.rbegin(); placeholder != placeholders.rend(); placeholder++)
         {
+            auto found = pattern.rfind(*placeholder);
 
-            auto left = matches[1].str();
-            auto mid = matches[2].str();
-            auto right = matches[3].str();
+            if (found == std::string_view::npos)
+                break;
 
-            translation_lookup.insert(make_pair(key, std::vector<std::string>{" " + left, mid, " " + right}));
-        };
-    }
-}
+            parts.push_back(std::string(pattern.substr(found + 1)));
+            pattern.remove_suffix(pattern.size() - found);
+        }
 
-void BaseSyntax::AddPrefixOperatorTranslation(std::map<std::string, std::string> map)
-{
-    auto const pattern = std::regex("(.*)A(.*)");
+        parts.push_back(std::string(pattern));
 
-    for (auto const &[key, val] : map)
-    {
-        std::smatch matches;
-        if (std::regex_search(val, matches, pattern))
-        {
+        if (parts.size() != placeholders.size() + 1)
+            continue;
+
+        std::reverse(parts.begin(), parts.end());
 
-            auto left = matches[1].str();
-            auto right = matches[2].str();
+        if (pad_first)
+            parts.front().insert(0, " ");
 
-            translation_lookup.insert(make_pair(key, std::vector<std::string>{" " + left, right}));
-        };
+        if (pad_last)
+            parts.back().insert(0, " ");
+
+        operators[atom].translation = std::move(parts);
     }
 }
 
-void BaseSyntax::AddPostfixOperatorTranslation(std::map<std::string, std::string> map)
+void BaseSyntax::AddBinaryOperatorTranslation(std::map<std::string, std::string> map)
 {
-    auto const pattern = std::regex("(.*)A(.*)");
-
-    for (auto const &[key, val] : map)
-    {
-        std::smatch matches;
-        if (std::regex_search(val, matches, pattern))
-        {
+    AddTranslations(binary_operators, map, "AB", true, true);
+}
 
-            auto left = matches[1].str();
-            auto right = matches[2].str();
+void BaseSyntax::AddPrefixOperatorTranslation(std::map<std::string, std::string> map)
+{
+    AddTranslations(prefix_operators, map, "A", true, false);
+}
 
-            translation_lookup.insert(make_pair(key, std::vector<std::string>{left, " " + right}));
-        };
-    }
+void BaseSyntax::AddPostfixOperatorTranslation(std::map<std::string, std::string> map)
+{
+    AddTranslations(postfix_operators, map, "A", false, true);
 }
 
 void BaseSyntax::AddNumberAnnotation(std::vector<std::string> vec)
 {
     number_annotations.insert(number_annotations.end(), vec.begin(), vec.end());
+
+    for (auto &str : vec)
+        number_annotation_matcher.Add(str);
 }
 
 void BaseSyntax::AddSymbols(const std::vector<std::string> strings)
@@ -144,19 +189,9 @@ void BaseSyntax::AddSymbols(const std::vector<std::string> strings)
             if (IsSymbol(c))
             {
                 symbols.push_back(str);
+                symbol_matcher.Add(str);
                 break;
             }
         }
     }
-
-    sort(symbols.begin(), symbols.end(), [](const std::string &a, const std::string &b)
-         { return a.size() > b.size(); });
-}
-
-void BaseSyntax::AddBinarySymbols(const std::vector<std::string> strings)
-{
-    for (auto &str : strings)
-    {
-        binary_operator_info[str] = new BinaryOperatorInfo();
-    }
 }
@@ -1,24 +1,65 @@
 #pragma once
 
-#include <vector>
+#include <array>
 #include <map>
-#include <set>
-#include <regex>
+#include <string>
+#include <vector>
+#include "./AtomTable.hpp"
+#include "./SymbolMatcher.hpp"
 
-struct BinaryOperatorInfo
+struct OperatorInfo
 {
-    uint8_t left_priority;
-    uint8_t right_priority;
+    // binary operators bind their left side with left_priority, right associative ones one level tighter
+    // the right side of binary and prefix operators is everything up to the next operator of at most right_priority
+    uint8_t left_priority = 0;
+    uint8_t right_priority = 0;
+    bool right_associative = false;
+    // the text around the operands when the operator is translated to plain lua, empty if it is kept as is
+    std::vector<std::string> translation;
 };
 
+// built once by the Get() of a derived syntax and never changed afterwards, so one instance is shared by
+// every lexer and parser on every thread
 class BaseSyntax
 {
-
 public:
+    BaseSyntax(const BaseSyntax &) = delete;
+    BaseSyntax &operator=(const BaseSyntax &) = delete;
+
+    const std::vector<std::string> &GetSymbols() const { return symbols; }
+    const std::vector<std::string> &GetNumberAnnotations() const { return number_annotations; }
+    const SymbolMatcher &GetSymbolMatcher() const { return symbol_matcher; }
+    const SymbolMatcher &GetNumberAnnotationMatcher() const { return number_annotation_matcher; }
+    bool IsPrefixOperator(Atom::Id atom) const { return HasFlag(atom, AtomFlag::PrefixOperator); }
+    bool IsPostfixOperator(Atom::Id atom) const { return HasFlag(atom, AtomFlag::PostfixOperator); }
+    bool IsBinaryOperator(Atom::Id atom) const { return HasFlag(atom, AtomFlag::PrimaryBinaryOperator); }
+    bool IsKeyword(Atom::Id atom) const { return HasFlag(atom, AtomFlag::Keyword); }
+    bool IsKeywordValue(Atom::Id atom) const { return HasFlag(atom, AtomFlag::KeywordValue); }
+    // nullptr unless the atom is that kind of operator in this syntax
+    const OperatorInfo *GetPrefixOperatorInfo(Atom::Id atom) const
+    {
+        return HasFlag(atom, AtomFlag::PrefixOperator) ? &prefix_operators[atom] : nullptr;
+    }
+    const OperatorInfo *GetPostfixOperatorInfo(Atom::Id atom) const
+    {
+        return HasFlag(atom, AtomFlag::PostfixOperator) ? &postfix_operators[atom] : nullptr;
+    }
+    const OperatorInfo *GetBinaryOperatorInfo(Atom::Id atom) const
+    {
+        return HasFlag(atom, AtomFlag::BinaryOperator) ? &binary_operators[atom] : nullptr;
+    }
+
+protected:
+    BaseSyntax() = default;
+
     void AddPrefixOperators(std::vector<std::string> vec);
     void AddPostfixOperators(std::vector<std::string> vec);
     void AddPrimaryBinaryOperators(std::vector<std::string> vec);
+    // groups from lowest to highest priority, an R prefix makes the operator right associative
+    // replaces the binary operators of an earlier call, so a derived syntax can define its own priorities
     void AddBinaryOperators(std::vector<std::vector<std::string>> operators);
+    // prefix operators bind tighter than the binary operator op and its group, but looser than the groups above it
+    void SetPrefixOperatorPriority(std::string_view op);
     void AddKeywords(std::vector<std::string> vec);
     void AddNonStandardKeywords(std::vector<std::string> vec);
     void AddKeywordValues(std::vector<std::string> vec);
@@ -28,45 +69,36 @@ public:
     void AddPostfixOperatorTranslation(std::map<std::string, std::string> map);
     void AddNumberAnnotation(std::vector<std::string> vec);
 
-    auto GetSymbols() { return symbols; }
-    auto GetNumberAnnotations() { return number_annotations; }
-    bool IsPrefixOperator(const std::string_view &op)
-    {
-        return prefix_operators_lookup.contains(std::string(op));
-    }
-    bool IsPostfixOperator(const std::string_view &op)
-    {
-        return postfix_operators_lookup.contains(std::string(op));
-    }
-    bool IsBinaryOperator(const std::string_view &op)
-    {
-        return primary_binary_operators_lookup.contains(std::string(op));
-    }
-    bool IsKeyword(const std::string_view &kw)
-    {
-        return keyword_lookup.contains(std::string(kw));
-    }
-    bool IsKeywordValue(const std::string_view &kw)
-    {
-        return keyword_values_lookup.contains(std::string(kw));
-    }
-    BinaryOperatorInfo *GetBinaryOperatorInfo(const std::string_view &val)
-    {
-        return binary_operator_info[std::string(val)];
-    }
-
 private:
     std::vector<std::string> symbols;
     std::vector<std::string> number_annotations;
-    std::map<std::string, std::vector<std::string>> translation_lookup;
-    std::map<std::string, BinaryOperatorInfo *> binary_operator_info;
-    std::set<std::string> primary_binary_operators_lookup;
-    std::set<std::string> postfix_operators_lookup;
-    std::set<std::string> prefix_operators_lookup;
-    std::set<std::string> keyword_values_lookup;
-    std::set<std::string> keyword_lookup;
-    std::set<std::string> non_standard_keyword_lookup;
+    SymbolMatcher symbol_matcher;
+    SymbolMatcher number_annotation_matcher = SymbolMatcher(true);
+
+    enum AtomFlag : uint8_t
+    {
+        Keyword = 1 << 0,
+        NonStandardKeyword = 1 << 1,
+        KeywordValue = 1 << 2,
+        PrefixOperator = 1 << 3,
+        PostfixOperator = 1 << 4,
+        PrimaryBinaryOperator = 1 << 5,
+        BinaryOperator = 1 << 6,
+    };
 
+    // indexed by atom, every keyword and operator is one of the predefined atoms
+    std::array<uint8_t, Atom::PredefinedCount> atom_flags = {};
+    std::array<OperatorInfo, Atom::PredefinedCount> prefix_operators;
+    std::array<OperatorInfo, Atom::PredefinedCount> postfix_operators;
+    std::array<OperatorInfo, Atom::PredefinedCount> binary_operators;
+
+    inline bool HasFlag(Atom::Id atom, AtomFlag flag) const
+    {
+        return atom < atom_flags.size() && (atom_flags[atom] & flag);
+    }
+    void AddFlag(Atom::Id atom, AtomFlag flag);
+    void AddFlag(const std::vector<std::string> &strings, AtomFlag flag);
+    void AddBinaryOperator(std::string_view op, uint8_t priority, bool right_associative);
+    void AddTranslations(std::array<OperatorInfo, Atom::PredefinedCount> &operators, const std::map<std::string, std::string> &map, std::string_view placeholders, bool pad_first, bool pad_last);
     void AddSymbols(std::vector<std::string> strings);
-    void AddBinarySymbols(std::vector<std::string> strings);
 };
@@ -1,45 +1,80 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 
-static inline bool IsValidHex(uint8_t c)
+namespace CharacterClass
 {
-    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    constexpr uint8_t Letter = 1 << 0;
+    constexpr uint8_t DuringLetter = 1 << 1;
+    constexpr uint8_t Number = 1 << 2;
+    constexpr uint8_t Hex = 1 << 3;
+    constexpr uint8_t Space = 1 << 4;
+    constexpr uint8_t Symbol = 1 << 5;
+
+    constexpr std::array<uint8_t, 256> BuildTable()
+    {
+        std::array<uint8_t, 256> table = {};
+
+        for (size_t i = 0; i < table.size(); i++)
+        {
+            auto c = static_cast<uint8_t>(i);
+            uint8_t flags = 0;
+
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '@' || c >= 127)
+                flags |= Letter | DuringLetter;
+
+            if (c >= '0' && c <= '9')
+                flags |= Number | DuringLetter | Hex;
+
+            if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))
+                flags |= Hex;
+
+            if (c > 0 && c <= 32)
+                flags |= Space;
+
+            if (c != '_' &&
+                ((c >= '!' && c <= '/') ||
+                 (c >= ':' && c <= '?') ||
+                 (c >= '[' && c <= '`') ||
+                 (c >= '{' && c <= '~')))
+                flags |= Symbol;
+
+            table[i] = flags;
+        }
+
+        return table;
+    }
+
+    inline constexpr std::array<uint8_t, 256> table = BuildTable();
+}
+
+static inline constexpr bool IsValidHex(uint8_t c)
+{
+    return CharacterClass::table[c] & CharacterClass::Hex;
 }
 
-static inline bool IsLetter(uint8_t c)
+static inline constexpr bool IsLetter(uint8_t c)
 {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
-           c == '_' || c == '@' || c >= 127;
+    return CharacterClass::table[c] & CharacterClass::Letter;
 }
 
-static inline bool IsDuringLetter(uint8_t c)
+static inline constexpr bool IsDuringLetter(uint8_t c)
 {
-    return (
-        (c >= 'a' && c <= 'z') ||
-        (c >= '0' && c <= '9') ||
-        (c >= 'A' && c <= 'Z') ||
-        c == '_' ||
-        c == '@' ||
-        c >= 127);
+    return CharacterClass::table[c] & CharacterClass::DuringLetter;
 }
 
-static inline bool IsNumber(uint8_t c)
+static inline constexpr bool IsNumber(uint8_t c)
 {
-    return c >= '0' && c <= '9';
+    return CharacterClass::table[c] & CharacterClass::Number;
 }
 
-static inline bool IsSpace(uint8_t c)
+static inline constexpr bool IsSpace(uint8_t c)
 {
-    return c > 0 && c <= 32;
+    return CharacterClass::table[c] & CharacterClass::Space;
 }
 
-static inline bool IsSymbol(uint8_t c)
+static inline constexpr bool IsSymbol(uint8_t c)
 {
-    return (
-        c != '_' &&
-        ((c >= '!' && c <= '/') ||
-         (c >= ':' && c <= '?') ||
-         (c >= '[' && c <= '`') ||
-         (c >= '{' && c <= '~')));
+    return CharacterClass::table[c] & CharacterClass::Symbol;
 }
\ No newline at end of file
@@ -4,6 +4,13 @@
 class RuntimeSyntax : public BaseSyntax
 {
 public:
+    static const RuntimeSyntax &Get()
+    {
+        static const RuntimeSyntax syntax;
+        return syntax;
+    }
+
+protected:
     RuntimeSyntax()
     {
         AddNumberAnnotation({"ull",
@@ -87,6 +94,7 @@ public:
                             {"+", "-"},
                             {"*", "/", "/idiv/", "%"},
                             {"R^"}});
+        // as in lua, -x ^ 2 is -(x ^ 2) and -x * 2 is (-x) * 2
+        SetPrefixOperatorPriority("*");
     }
-    ~RuntimeSyntax() {}
 };
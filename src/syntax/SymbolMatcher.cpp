@@ -0,0 +1,72 @@
+#include "./SymbolMatcher.hpp"
+
+SymbolMatcher::SymbolMatcher(bool case_insensitive)
+{
+    this->case_insensitive = case_insensitive;
+}
+
+void SymbolMatcher::Add(std::string_view symbol)
+{
+    if (symbol.empty())
+        return;
+
+    auto first = Fold(symbol[0]);
+
+    if (!roots[first])
+    {
+        roots[first] = nodes.size();
+        nodes.push_back(Node{.byte = first});
+    }
+
+    auto node = roots[first];
+
+    for (size_t i = 1; i < symbol.size(); i++)
+    {
+        auto byte = Fold(symbol[i]);
+        auto child = nodes[node].child;
+
+        while (child && nodes[child].byte != byte)
+            child = nodes[child].sibling;
+
+        if (!child)
+        {
+            child = nodes.size();
+            nodes.push_back(Node{.byte = byte, .sibling = nodes[node].child});
+            nodes[node].child = child;
+        }
+
+        node = child;
+    }
+
+    nodes[node].terminal = true;
+}
+
+size_t SymbolMatcher::Match(std::string_view str) const
+{
+    if (str.empty())
+        return 0;
+
+    size_t longest = 0;
+    size_t length = 1;
+    auto node = roots[Fold(str[0])];
+
+    while (node)
+    {
+        if (nodes[node].terminal)
+            longest = length;
+
+        if (length >= str.size())
+            break;
+
+        auto byte = Fold(str[length]);
+        auto child = nodes[node].child;
+
+        while (child && nodes[child].byte != byte)
+            child = nodes[child].sibling;
+
+        node = child;
+        length++;
+    }
+
+    return longest;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// byte trie for finding the longest symbol at the start of a string
+// the first byte is looked up directly, the rest walks a child/sibling list
+class SymbolMatcher
+{
+public:
+    explicit SymbolMatcher(bool case_insensitive = false);
+
+    void Add(std::string_view symbol);
+
+    // length of the longest added symbol that str starts with, 0 if none
+    size_t Match(std::string_view str) const;
+
+private:
+    struct Node
+    {
+        uint8_t byte = 0;
+        bool terminal = false;
+        uint32_t child = 0;
+        uint32_t sibling = 0;
+    };
+
+    bool case_insensitive;
+    std::array<uint32_t, 256> roots = {};
+    std::vector<Node> nodes = {Node{}};
+
+    inline uint8_t Fold(uint8_t c) const
+    {
+        return (case_insensitive && c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+};
@@ -4,6 +4,13 @@
 class TypesystemSyntax : public RuntimeSyntax
 {
 public:
+    static const TypesystemSyntax &Get()
+    {
+        static const TypesystemSyntax syntax;
+        return syntax;
+    }
+
+protected:
     TypesystemSyntax() : RuntimeSyntax()
     {
         AddPrefixOperators({"-",
@@ -34,6 +41,7 @@ public:
                             {"+", "-"},
                             {"*", "/", "/idiv/", "%"},
                             {"R^"}});
+        // as in lua, -x ^ 2 is -(x ^ 2) and -x * 2 is (-x) * 2
+        SetPrefixOperatorPriority("*");
     }
-    ~TypesystemSyntax() {}
 };
\ No newline at end of file
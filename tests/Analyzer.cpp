@@ -6,10 +6,30 @@
 
 TEST(Analyzer, Atomic)
 {
-    auto ast = std::shared_ptr<Expression>(cast_uptr<ParserNode, Expression>(Parse("0x123")).release());
-    auto analyzer = std::make_shared<LuaAnalyzer>();
+    auto ast = cast_uptr<ParserNode, Expression>(Parse("0x123"));
+    auto analyzer = std::make_shared<LuaAnalyzer>(ast.GetStorage()->tokens);
 
-    auto num = cast<Number>(analyzer->AnalyzeExpression(ast, ParserNode::Runtime).get());
+    auto num = cast<Number>(analyzer->AnalyzeExpression(ast.get(), ParserNode::Runtime).get());
 
     EXPECT_EQ(num->value, 0x123);
 }
+
+TEST(Analyzer, LargeHexNumber)
+{
+    auto ast = cast_uptr<ParserNode, Expression>(Parse("0xffffffffff"));
+    auto analyzer = std::make_shared<LuaAnalyzer>(ast.GetStorage()->tokens);
+
+    auto num = cast<Number>(analyzer->AnalyzeExpression(ast.get(), ParserNode::Runtime).get());
+
+    EXPECT_EQ(num->value, 0xffffffffff);
+}
+
+TEST(Analyzer, String)
+{
+    auto ast = cast_uptr<ParserNode, Expression>(Parse("'a\\tb'"));
+    auto analyzer = std::make_shared<LuaAnalyzer>(ast.GetStorage()->tokens);
+
+    auto str = cast<String>(analyzer->AnalyzeExpression(ast.get(), ParserNode::Runtime).get());
+
+    EXPECT_EQ(str->value, "a\tb");
+}
@@ -2,28 +2,19 @@
 
 #include "../src/lexer/LuaLexer.hpp"
 #include "../src/parser/LuaParser.hpp"
-#include "../src/parser/PrimaryExpression.hpp"
+#include "../src/parser/Statement.hpp"
 
 template <typename From, typename To>
-inline std::unique_ptr<To> cast_uptr(std::unique_ptr<From> &&ptr)
+inline ParseResult<To> cast_uptr(ParseResult<From> &&result)
 {
-    auto const stored_ptr = ptr.release();
-    To *const converted_stored_ptr = dynamic_cast<To *>(stored_ptr);
-    if (converted_stored_ptr)
-    {
-        return std::unique_ptr<To>(converted_stored_ptr);
-    }
-    else
-    {
-        ptr.reset(stored_ptr);
-        return std::unique_ptr<To>();
-    }
+    return ParseResult<To>(NodeCast<To>(result.get()), result.GetStorage());
 }
 
 template <class T>
 inline auto cast(auto node)
 {
-    auto val = dynamic_cast<T *>(node);
+    // parser nodes and analyzer types both carry a kind instead of rtti
+    auto val = node && T::IsKind(node->kind) ? static_cast<T *>(node) : nullptr;
     EXPECT_TRUE(val != nullptr);
     return val;
 }
@@ -42,6 +33,49 @@ inline std::vector<std::unique_ptr<Token>> Tokenize(std::string_view code)
     return std::move(tokens);
 }
 
+inline TokenBuffer TokenizeBuffer(std::string_view code)
+{
+    auto code_obj = std::make_shared<Code>(code, "test");
+    auto lexer = std::make_shared<LuaLexer>(code_obj);
+    auto buffer = lexer->GetTokenBuffer();
+
+    for (auto &diagnostic : buffer.diagnostics)
+    {
+        printf("%s", diagnostic.GetMessage(code).c_str());
+    }
+
+    return buffer;
+}
+
+inline void ExpectSameTokenBuffer(const TokenBuffer &a, const TokenBuffer &b)
+{
+    EXPECT_EQ(a.kinds, b.kinds);
+    EXPECT_EQ(a.starts, b.starts);
+    EXPECT_EQ(a.lengths, b.lengths);
+    EXPECT_EQ(a.states, b.states);
+    EXPECT_EQ(a.atoms, b.atoms);
+    EXPECT_EQ(a.whitespace_offsets, b.whitespace_offsets);
+    ASSERT_EQ(a.numbers.size(), b.numbers.size());
+
+    for (size_t i = 0; i < a.numbers.size(); i++)
+    {
+        EXPECT_EQ(a.numbers[i].token, b.numbers[i].token);
+        EXPECT_EQ(a.numbers[i].value.unsigned_integer, b.numbers[i].value.unsigned_integer);
+    }
+
+    EXPECT_EQ(a.whitespace_kinds, b.whitespace_kinds);
+    EXPECT_EQ(a.whitespace_starts, b.whitespace_starts);
+    EXPECT_EQ(a.whitespace_lengths, b.whitespace_lengths);
+    ASSERT_EQ(a.diagnostics.size(), b.diagnostics.size());
+
+    for (size_t i = 0; i < a.diagnostics.size(); i++)
+    {
+        EXPECT_EQ(a.diagnostics[i].code, b.diagnostics[i].code);
+        EXPECT_EQ(a.diagnostics[i].start, b.diagnostics[i].start);
+        EXPECT_EQ(a.diagnostics[i].stop, b.diagnostics[i].stop);
+    }
+}
+
 inline std::unique_ptr<Token> OneToken(std::vector<std::unique_ptr<Token>> tokens)
 {
     if (tokens.size() != 2)
@@ -89,10 +123,18 @@ inline void Check(std::string_view lua_code)
     EXPECT_EQ(actual_tokens, lua_code);
 }
 
-inline auto Parse(std::string_view code)
+inline ParseResult<ParserNode> Parse(std::string_view code)
 {
     auto tokens = Tokenize(code);
-    auto parser = std::make_shared<LuaParser>(std::move(tokens));
-    auto node = cast_uptr<Expression, ParserNode>(std::move(ValueExpression::Parse(parser)));
-    return std::move(node);
+    auto parser = LuaParser(std::move(tokens));
+    auto result = parser.ParseExpression();
+    return ParseResult<ParserNode>(result.get(), result.GetStorage());
+}
+
+inline ParseResult<Root> ParseFile(std::string_view code)
+{
+    auto parser = LuaParser(TokenizeBuffer(code));
+    auto result = parser.ParseFile();
+    EXPECT_TRUE(result.GetDiagnostics().empty()) << code;
+    return result;
 }
\ No newline at end of file
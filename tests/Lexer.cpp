@@ -1,11 +1,298 @@
 #include <assert.h>
+#include <cmath>
 #include <gtest/gtest.h>
 #include "./Helpers.hpp"
+#include "../src/lexer/NumberLiteral.hpp"
+#include "../src/lexer/ScanKernels.hpp"
+#include "../src/lexer/StringLiteral.hpp"
+#include "../src/lexer/TriviaReader.hpp"
+#include "../src/syntax/CharacterClasses.hpp"
 
 TEST(Lexer, TokensToString)
 {
     Check("local foo =   5 + 2..2");
 }
+TEST(Lexer, TokenBuffer)
+{
+    auto code = "#!shebang\nlocal foo = 5 -- comment\n--[[ long ]] print('a', [[b]], 0xff) /* c */ §debug";
+    auto tokens = Tokenize(code);
+    auto buffer = TokenizeBuffer(code);
+
+    EXPECT_EQ(buffer.Size(), tokens.size());
+
+    for (size_t i = 0; i < tokens.size(); i++)
+    {
+        EXPECT_EQ(buffer.GetKind(i), tokens[i]->kind);
+        EXPECT_EQ(buffer.GetStart(i), tokens[i]->start);
+        EXPECT_EQ(buffer.GetStop(i), tokens[i]->stop);
+        EXPECT_EQ(buffer.GetValue(i), tokens[i]->value);
+        EXPECT_EQ(buffer.GetWhitespaceCount(i), tokens[i]->whitespace.size());
+    }
+
+    EXPECT_EQ(TokensToString(buffer.ToTokens()), code);
+}
+
+TEST(Lexer, TokenIterator)
+{
+    auto code = std::make_shared<Code>("local a = 1 -- comment\nprint(a)", "test");
+    auto lexer = std::make_shared<LuaLexer>(code);
+    auto tokens = Tokenize(code->GetBuffer());
+    size_t i = 0;
+
+    for (auto &token : *lexer)
+    {
+        ASSERT_LT(i, tokens.size());
+        EXPECT_EQ(token->kind, tokens[i]->kind);
+        EXPECT_EQ(token->value, tokens[i]->value);
+        EXPECT_EQ(token->whitespace.size(), tokens[i]->whitespace.size());
+        i++;
+    }
+
+    EXPECT_EQ(i, tokens.size());
+}
+
+// replaces removed bytes at start with text and checks that relexing gives the same result as lexing everything
+static size_t ExpectRelex(std::string before, size_t start, size_t removed, std::string text)
+{
+    auto after = before;
+    after.replace(start, removed, text);
+
+    auto previous = TokenizeBuffer(before);
+    auto code = std::make_shared<Code>(after, "test");
+    auto lexer = std::make_shared<LuaLexer>(code);
+    auto relexed = lexer->Relex(previous, {.start = start, .removed = removed, .inserted = text.size()});
+    auto relexed_until = lexer->position;
+
+    ExpectSameTokenBuffer(relexed, lexer->GetTokenBuffer());
+
+    return relexed_until;
+}
+
+TEST(Lexer, Relex)
+{
+    auto code = std::string("local foo = 1\nlocal bar = 'str' -- comment\nprint(foo, bar)\n");
+
+    ExpectRelex(code, 0, 0, "#!shebang\n");
+    ExpectRelex(code, 8, 0, "oo");
+    ExpectRelex(code, 6, 3, "");
+    ExpectRelex(code, 13, 1, "");
+    ExpectRelex(code, 12, 1, "0x");
+    ExpectRelex(code, 26, 0, "'");
+    ExpectRelex(code, 14, 0, "[[");
+    ExpectRelex(code, 14, 0, "--[==[");
+    ExpectRelex(code, 14, 0, "'");
+    ExpectRelex(code, code.size(), 0, "1e");
+    ExpectRelex(code, code.size(), 0, "[=");
+    ExpectRelex(code, 0, code.size(), "");
+
+    auto long_string = std::string("local a = [[\nfoo\nbar]] local b = 1\n");
+    ExpectRelex(long_string, 17, 0, "]]");
+    ExpectRelex(long_string, 21, 2, "");
+    ExpectRelex(long_string, 10, 1, "");
+
+    auto comment_escape = std::string("local a = 1\n--[[# local b: number ]]\nlocal c = 2\n");
+    ExpectRelex(comment_escape, 17, 0, "x");
+    ExpectRelex(comment_escape, 34, 2, "");
+    ExpectRelex(comment_escape, 16, 1, "");
+    ExpectRelex(comment_escape, 12, 0, "--[[#");
+
+    // closing a long string or comment that was unfinished up to the end of the code
+    ExpectRelex("a = [[\nfoo\n", 11, 0, "]]");
+    ExpectRelex("a = 1 --[[\nfoo\n", 15, 0, "]]");
+    ExpectRelex("a = 1 --[[\nfoo\nb = 2\n", 21, 0, "]]");
+    ExpectRelex("a = 'x\\z\nfoo", 12, 0, "'");
+}
+
+TEST(Lexer, RelexRandomEdits)
+{
+    auto code = std::string("local a = [[x]] --[[# local b = 1 ]]\n-- c\nlocal d = 'e' .. 0x1p4\n--[==[ f ]==]\n");
+    auto alphabet = std::string("[]=-#'\"\\\n a1.");
+    uint32_t seed = 1337;
+
+    auto random = [&](size_t max)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % max;
+    };
+
+    for (int i = 0; i < 500; i++)
+    {
+        auto start = random(code.size() + 1);
+        auto removed = std::min<size_t>(random(4), code.size() - start);
+        auto text = std::string();
+
+        for (auto length = random(4); length > 0; length--)
+            text += alphabet[random(alphabet.size())];
+
+        ExpectRelex(code, start, removed, text);
+        code.replace(start, removed, text);
+    }
+}
+
+TEST(Lexer, RelexOnlyAroundEdit)
+{
+    auto code = std::string();
+
+    for (int i = 0; i < 1000; i++)
+        code += "local x" + std::to_string(i) + " = " + std::to_string(i) + "\n";
+
+    auto start = code.size() / 2;
+    auto relexed_until = ExpectRelex(code, start, 0, "y");
+
+    EXPECT_LT(relexed_until, start + 100);
+}
+
+TEST(Lexer, GetTokenBufferInParallel)
+{
+    auto code = std::string(
+        "#!shebang\n"
+        "local a = [[\nlocal not_a_token = 1\n]] local b = 0x1p4\n"
+        "--[==[\n'\n]==] local c = 'd'\n"
+        "--[[# local e: number\n local f = 2 ]]\n"
+        "local g = \"unfinished\n"
+        "local h = 1e+\n"
+        "-- line comment [[\n"
+        "local i = [[\n");
+
+    auto lexer = LuaLexer(std::make_shared<Code>(code, "test"));
+    auto serial = lexer.GetTokenBuffer();
+
+    for (size_t chunk_size = 1; chunk_size < code.size(); chunk_size++)
+    {
+        ExpectSameTokenBuffer(lexer.GetTokenBufferInParallel(4, chunk_size), serial);
+    }
+}
+
+TEST(Lexer, Atoms)
+{
+    auto tokens = Tokenize("local foo = foo + 1 .. 'foo'");
+
+    EXPECT_EQ(tokens[0]->atom, Atom::Local);
+    EXPECT_EQ(tokens[1]->atom, tokens[3]->atom);
+    EXPECT_GE(tokens[1]->atom, Atom::PredefinedCount);
+    EXPECT_EQ(AtomTable::GetString(tokens[1]->atom), "foo");
+    EXPECT_EQ(tokens[2]->atom, Atom::Assign);
+    EXPECT_EQ(tokens[4]->atom, Atom::Plus);
+    EXPECT_EQ(tokens[5]->atom, Atom::None);
+    EXPECT_EQ(tokens[6]->atom, Atom::Concat);
+    EXPECT_EQ(tokens[7]->atom, Atom::None);
+
+    EXPECT_EQ(AtomTable::Find("function"), Atom::Function);
+    EXPECT_EQ(AtomTable::Find("never interned"), Atom::None);
+
+    auto buffer = TokenizeBuffer("local foo = foo + 1 .. 'foo'");
+
+    for (size_t i = 0; i < tokens.size(); i++)
+        EXPECT_EQ(buffer.GetAtom(i), tokens[i]->atom);
+}
+
+static NumberValue DecodedNumber(std::string_view code)
+{
+    auto token = OneToken(Tokenize(code));
+    EXPECT_EQ(token->kind, Token::Kind::Number);
+    EXPECT_TRUE(token->number.has_value());
+    return *token->number;
+}
+
+TEST(Lexer, NumberValues)
+{
+    EXPECT_EQ(DecodedNumber("1337").number, 1337);
+    EXPECT_EQ(DecodedNumber("3.14159").number, 3.14159);
+    EXPECT_EQ(DecodedNumber(".5").number, 0.5);
+    EXPECT_EQ(DecodedNumber("1_000_000").number, 1000000);
+    EXPECT_EQ(DecodedNumber("1.5e+10").number, 1.5e10);
+    EXPECT_EQ(DecodedNumber("2.5E-3").number, 2.5e-3);
+    EXPECT_EQ(DecodedNumber("123456789012345678901234567890").number, 123456789012345678901234567890.0);
+    EXPECT_EQ(DecodedNumber("0x123").number, 0x123);
+    EXPECT_EQ(DecodedNumber("0xffffffffffffffff").number, 18446744073709551615.0);
+    EXPECT_EQ(DecodedNumber("0x1ffffffffffffffff").number, 36893488147419103231.0);
+    EXPECT_EQ(DecodedNumber("0x1.8p+4").number, 24);
+    EXPECT_EQ(DecodedNumber("0x1_0p-1").number, 8);
+    EXPECT_EQ(DecodedNumber("0b1010").number, 10);
+    EXPECT_EQ(DecodedNumber("0b1_1").number, 3);
+
+    auto unsigned_value = DecodedNumber("0xffffffffffffffffULL");
+    EXPECT_EQ(unsigned_value.suffix, NumberValue::Suffix::ULL);
+    EXPECT_EQ(unsigned_value.unsigned_integer, UINT64_MAX);
+
+    auto signed_value = DecodedNumber("0xffffffffffffffffll");
+    EXPECT_EQ(signed_value.suffix, NumberValue::Suffix::LL);
+    EXPECT_EQ(signed_value.integer, -1);
+
+    EXPECT_EQ(DecodedNumber("50ul").suffix, NumberValue::Suffix::UL);
+    EXPECT_EQ(DecodedNumber("50ul").unsigned_integer, 50);
+
+    // too large for a double is inf and too small is 0, like lua
+    EXPECT_EQ(DecodedNumber("1e+400").number, HUGE_VAL);
+    EXPECT_EQ(DecodedNumber("0x1p+2000").number, HUGE_VAL);
+    EXPECT_EQ(DecodedNumber("1e-400").number, 0);
+    EXPECT_EQ(NumberLiteral::Decode("1e309").number, HUGE_VAL);
+
+    // integer suffixes saturate
+    EXPECT_EQ(DecodedNumber("1e+30ll").integer, INT64_MAX);
+    EXPECT_EQ(DecodedNumber("1e+30ull").unsigned_integer, UINT64_MAX);
+    EXPECT_EQ(DecodedNumber("1e+400ull").unsigned_integer, UINT64_MAX);
+
+    auto imaginary = DecodedNumber("2i");
+    EXPECT_EQ(imaginary.suffix, NumberValue::Suffix::I);
+    EXPECT_EQ(imaginary.number, 2);
+
+    auto buffer = TokenizeBuffer("local a = 1 + 0x10 .. 'x' .. 2e+2");
+    EXPECT_EQ(buffer.numbers.size(), 3);
+    EXPECT_EQ(buffer.GetNumber(3)->number, 1);
+    EXPECT_EQ(buffer.GetNumber(5)->number, 16);
+    EXPECT_EQ(buffer.GetNumber(9)->number, 200);
+    EXPECT_EQ(buffer.GetNumber(4), nullptr);
+}
+
+static std::string StringValue(std::string_view code)
+{
+    auto buffer = TokenizeBuffer(code);
+    EXPECT_EQ(buffer.GetKind(0), Token::Kind::String);
+    auto cache = StringLiteralCache();
+    return std::string(cache.Get(buffer, 0));
+}
+
+TEST(Lexer, StringValues)
+{
+    EXPECT_EQ(StringValue("'foo'"), "foo");
+    EXPECT_EQ(StringValue("\"\""), "");
+    EXPECT_EQ(StringValue("'a\\nb'"), "a\nb");
+    EXPECT_EQ(StringValue("'\\a\\b\\f\\r\\t\\v'"), "\a\b\f\r\t\v");
+    EXPECT_EQ(StringValue("'\\\\ \\\" \\''"), "\\ \" '");
+    EXPECT_EQ(StringValue("'a\\z  \n  b'"), "ab");
+    EXPECT_EQ(StringValue("'a\\\nb'"), "a\nb");
+    EXPECT_EQ(StringValue("'\\x41\\x7a'"), "Az");
+    EXPECT_EQ(StringValue("'\\65\\0669'"), "AB9");
+    EXPECT_EQ(StringValue("'\\u{48}\\u{E9}\\u{20AC}\\u{1F600}'"), "H\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+    EXPECT_EQ(StringValue("'\\u{7FFFFFFF}\\u{0000000041}'"), "\xFD\xBF\xBF\xBF\xBF\xBF" "A");
+
+    // escapes lua rejects are kept as written and reported by the lexer
+    EXPECT_EQ(StringValue("'\\u{FFFFFFFF}'"), "u{FFFFFFFF}");
+    EXPECT_EQ(StringValue("'\\u{12G4}'"), "u{12G4}");
+    auto escapes = TokenizeBuffer("'\\u{80000000}' '\\u{FFFFFFFFFFFF}' '\\u{12G4}' '\\u{}' '\\u{41' '\\u{41}'");
+    EXPECT_EQ(escapes.diagnostics.size(), 5);
+    for (auto &diagnostic : escapes.diagnostics)
+        EXPECT_EQ(diagnostic.code, LexerDiagnostic::MalformedUtf8Escape);
+    EXPECT_EQ(escapes.GetKind(0), Token::Kind::String);
+
+    EXPECT_EQ(StringValue("[[foo]]"), "foo");
+    EXPECT_EQ(StringValue("[[\nfoo\n]]"), "foo\n");
+    EXPECT_EQ(StringValue("[==[\r\n]]\\n]==]"), "]]\\n");
+
+    // values without escapes point into the code, the others are unescaped once
+    auto code = std::string("local a, b = 'plain', 'esc\\n'");
+    auto buffer = TokenizeBuffer(code);
+    auto cache = StringLiteralCache();
+    auto plain = cache.Get(buffer, 5);
+    auto escaped = cache.Get(buffer, 7);
+
+    EXPECT_EQ(plain, "plain");
+    EXPECT_EQ(plain.data(), buffer.GetValue(5).data() + 1);
+    EXPECT_EQ(escaped, "esc\n");
+    EXPECT_EQ(cache.Get(buffer, 7).data(), escaped.data());
+}
+
 TEST(Lexer, Smoke)
 {
     EXPECT_EQ(Tokenize("")[0]->kind, Token::Kind::EndOfFile);
@@ -51,6 +338,56 @@ TEST(Lexer, ZEscapedString)
     ExpectError("\"a\\z\n\n--foo  \na\"", "expected ending \" quote, got newline");
 }
 
+TEST(Lexer, EscapedQuoteString)
+{
+    EXPECT_EQ(OneToken(Tokenize("\"a\\\"b\""))->value, "\"a\\\"b\"");
+    EXPECT_EQ(OneToken(Tokenize("'a\\\\'"))->value, "'a\\\\'");
+    EXPECT_EQ(OneToken(Tokenize("'a\\\nb'"))->value, "'a\\\nb'");
+}
+
+TEST(Lexer, ScanKernels)
+{
+    std::string code;
+
+    for (size_t i = 0; i < 200; i++)
+        code += static_cast<char>((i * 7919 + i / 3) % 256);
+
+    code += "  \t\n  identifier_with_@_and_123  \"quoted \\\" string\"  -- comment\n";
+    code += std::string(70, ' ') + std::string(70, 'a') + "'" + std::string(70, 'b');
+
+    auto check_all = [&]()
+    {
+        for (size_t from = 0; from <= code.size(); from++)
+        {
+            auto space = from;
+            while (space < code.size() && IsSpace(code[space]))
+                space++;
+
+            auto letter = from;
+            while (letter < code.size() && IsDuringLetter(code[letter]))
+                letter++;
+
+            auto newline = code.find('\n', from);
+            auto quote = code.find_first_of(std::string("'\\\n"), from);
+
+            EXPECT_EQ(ScanKernels::SkipSpace(code, from), space);
+            EXPECT_EQ(ScanKernels::SkipDuringLetter(code, from), letter);
+            EXPECT_EQ(ScanKernels::FindNewline(code, from), newline == std::string::npos ? code.size() : newline);
+            EXPECT_EQ(ScanKernels::FindQuotedStringEnd(code, from, '\''), quote == std::string::npos ? code.size() : quote);
+        }
+    };
+
+    auto original = ScanKernels::GetImplementation();
+
+    for (auto implementation : {ScanKernels::Implementation::Scalar, ScanKernels::Implementation::SSE2, ScanKernels::Implementation::AVX2})
+    {
+        if (ScanKernels::SetImplementation(implementation))
+            check_all();
+    }
+
+    ScanKernels::SetImplementation(original);
+}
+
 TEST(Lexer, NumberRange)
 {
     EXPECT_EQ(Tokenize("1..20").size(), 4);
@@ -72,6 +409,11 @@ TEST(Lexer, NumberAnnotations)
     EXPECT_EQ(Tokenize("50lL").size(), 2);
     EXPECT_EQ(Tokenize("1.5e+20").size(), 2);
     EXPECT_EQ(Tokenize(".0").size(), 2);
+
+    EXPECT_EQ(OneToken(Tokenize("50ULL"))->value, "50ULL");
+    EXPECT_EQ(OneToken(Tokenize("0xffull"))->value, "0xffull");
+    EXPECT_EQ(OneToken(Tokenize("0b101ll"))->value, "0b101ll");
+    EXPECT_EQ(OneToken(Tokenize("2i"))->value, "2i");
 }
 
 TEST(Lexer, MalformedNumber)
@@ -95,12 +437,57 @@ TEST(Lexer, StringError)
     ExpectError("'aaa", "expected ending ' quote, reached end of code");
 }
 
+TEST(Lexer, ErrorRecovery)
+{
+    auto code = "local x = 12LOL + 'abc\nfoo(1.5e+D) --[[ [==[ 0b12";
+    auto tokens = Tokenize(code);
+
+    std::vector<std::pair<Token::Kind, std::string_view>> expected = {
+        {Token::Kind::Letter, "local"},
+        {Token::Kind::Letter, "x"},
+        {Token::Kind::Symbol, "="},
+        {Token::Kind::Error, "12LOL"},
+        {Token::Kind::Symbol, "+"},
+        {Token::Kind::Error, "'abc"},
+        {Token::Kind::Letter, "foo"},
+        {Token::Kind::Symbol, "("},
+        {Token::Kind::Error, "1.5e+D"},
+        {Token::Kind::Symbol, ")"},
+        {Token::Kind::Error, "--[["},
+        {Token::Kind::Error, "[==["},
+        {Token::Kind::Error, "0b12"},
+        {Token::Kind::EndOfFile, ""},
+    };
+
+    EXPECT_EQ(tokens.size(), expected.size());
+
+    for (size_t i = 0; i < expected.size() && i < tokens.size(); i++)
+    {
+        EXPECT_EQ(tokens[i]->kind, expected[i].first);
+        EXPECT_EQ(tokens[i]->value, expected[i].second);
+    }
+
+    EXPECT_EQ(TokensToString(std::move(tokens)), code);
+
+    auto buffer = TokenizeBuffer(code);
+    EXPECT_EQ(buffer.diagnostics.size(), 6);
+    EXPECT_EQ(buffer.diagnostics[0].code, LexerDiagnostic::MalformedDecimalNumber);
+    EXPECT_EQ(buffer.diagnostics[1].GetMessage(code), "expected ending ' quote, got newline");
+}
+
 TEST(Lexer, MultilineString)
 {
     EXPECT_EQ(Tokenize("a = [[a]]").size(), 4);
     EXPECT_EQ(Tokenize("a = [=[a]=]").size(), 4);
     EXPECT_EQ(Tokenize("a = [==[a]==]").size(), 4);
 
+    EXPECT_EQ(OneToken(Tokenize("[==[ ] ]] ]=] ]===] ]=]=] ]==]"))->value, "[==[ ] ]] ]=] ]===] ]=]=] ]==]");
+    EXPECT_EQ(OneToken(Tokenize("[[]]"))->value, "[[]]");
+    EXPECT_EQ(OneToken(Tokenize("[=[]]]=]"))->value, "[=[]]]=]");
+
+    auto huge = "[=[" + std::string(1024 * 1024, ']') + "]=]";
+    EXPECT_EQ(OneToken(Tokenize(huge))->value.size(), huge.size());
+
     ExpectError("a = [=a", "malformed multiline string: expected =, got a");
     ExpectError("a = [[a", "expected multiline string to end, reached end of code");
 }
@@ -110,6 +497,8 @@ TEST(Lexer, MultilineComment)
     EXPECT_EQ(Tokenize("--[[a]]")[0]->kind, Token::Kind::EndOfFile);
     EXPECT_EQ(Tokenize("--[=[a]=]")[0]->kind, Token::Kind::EndOfFile);
     EXPECT_EQ(Tokenize("--[==[a]==]")[0]->kind, Token::Kind::EndOfFile);
+    EXPECT_EQ(Tokenize("--[==[a]] ]=] ]==]")[0]->kind, Token::Kind::EndOfFile);
+    EXPECT_EQ(Tokenize("--[=[a]] ]==] ]=] 1")[0]->kind, Token::Kind::Number);
     EXPECT_EQ(Tokenize("/*a*/")[0]->kind, Token::Kind::EndOfFile);
 }
 
@@ -123,6 +512,114 @@ TEST(Lexer, LineComment)
 TEST(Lexer, CommentEscape)
 {
     EXPECT_EQ(Tokenize("--[[# 1337 ]]")[0]->kind, Token::Kind::Number);
+
+    auto tokens = Tokenize("--[[# 1337 ]] 1");
+    EXPECT_EQ(tokens.size(), 3);
+    EXPECT_EQ(tokens[0]->value, "1337");
+    EXPECT_EQ(tokens[1]->whitespace[1]->kind, Token::Kind::CommentEscape);
+    EXPECT_EQ(tokens[1]->whitespace[1]->value, "]]");
+}
+
+TEST(Lexer, WithoutWhitespace)
+{
+    auto code = std::make_shared<Code>("-- comment\nlocal a = 1 --[[ long ]] --[[# 1337 ]] /* c */ + 2\n", "test");
+
+    auto full = LuaLexer(code).GetTokenBuffer();
+
+    auto lexer = LuaLexer(code);
+    lexer.keep_whitespace = false;
+    auto buffer = lexer.GetTokenBuffer();
+
+    // same tokens and states, the comment escape is still honoured
+    EXPECT_EQ(buffer.kinds, full.kinds);
+    EXPECT_EQ(buffer.starts, full.starts);
+    EXPECT_EQ(buffer.states, full.states);
+    EXPECT_EQ(buffer.atoms, full.atoms);
+    EXPECT_EQ(buffer.GetValue(4), "1337");
+    EXPECT_TRUE(buffer.whitespace_kinds.empty());
+    EXPECT_EQ(buffer.whitespace_offsets, std::vector<uint32_t>(buffer.Size() + 1, 0));
+
+    auto [tokens, errors] = lexer.GetTokens();
+    ASSERT_EQ(tokens.size(), buffer.Size());
+
+    for (size_t i = 0; i < tokens.size(); i++)
+    {
+        EXPECT_EQ(tokens[i]->kind, buffer.GetKind(i));
+        EXPECT_EQ(tokens[i]->value, buffer.GetValue(i));
+        EXPECT_TRUE(tokens[i]->whitespace.empty());
+    }
+
+    ExpectSameTokenBuffer(lexer.GetTokenBufferInParallel(4, 1), buffer);
+}
+
+TEST(Lexer, TriviaReader)
+{
+    auto code = std::make_shared<Code>("#!shebang\nlocal a = 1 -- comment\n--[[# 1337 ]] /* c */ print(a)  --[[ long ]]\n", "test");
+    auto full = LuaLexer(code).GetTokenBuffer();
+
+    auto lexer = LuaLexer(code);
+    lexer.keep_whitespace = false;
+    auto buffer = lexer.GetTokenBuffer();
+
+    auto reader = TriviaReader(lexer, buffer);
+    auto tokens = std::vector<std::unique_ptr<Token>>();
+
+    for (size_t i = 0; i < buffer.Size(); i++)
+    {
+        auto trivia = reader.Get(i);
+        ASSERT_EQ(trivia.size(), full.GetWhitespaceCount(i));
+
+        for (size_t j = 0; j < trivia.size(); j++)
+        {
+            auto w = full.whitespace_offsets[i] + j;
+            EXPECT_EQ(trivia[j].kind, full.whitespace_kinds[w]);
+            EXPECT_EQ(trivia[j].start, full.whitespace_starts[w]);
+            EXPECT_EQ(trivia[j].stop - trivia[j].start, full.whitespace_lengths[w]);
+        }
+
+        auto token = buffer.ToToken(i);
+        token->whitespace = reader.GetTokens(i);
+        tokens.push_back(std::move(token));
+    }
+
+    EXPECT_EQ(TokensToString(std::move(tokens)), code->GetBuffer());
+
+    auto cached = TriviaReader(lexer, buffer, true);
+    EXPECT_EQ(cached.Get(5).data(), cached.Get(5).data());
+    EXPECT_EQ(cached.Get(5).size(), full.GetWhitespaceCount(5));
+}
+
+TEST(Lexer, SharedSyntax)
+{
+    auto code = std::make_shared<Code>("local a = 1", "test");
+    auto a = LuaLexer(code);
+    auto b = LuaLexer(code);
+
+    EXPECT_EQ(a.runtime_syntax, b.runtime_syntax);
+    EXPECT_EQ(a.typesystem_syntax, b.typesystem_syntax);
+    EXPECT_EQ(a.runtime_syntax, &RuntimeSyntax::Get());
+    EXPECT_TRUE(RuntimeSyntax::Get().IsKeyword(Atom::Local));
+    EXPECT_FALSE(RuntimeSyntax::Get().IsPrefixOperator(Atom::Typeof));
+    EXPECT_TRUE(TypesystemSyntax::Get().IsPrefixOperator(Atom::Typeof));
+    EXPECT_EQ(RuntimeSyntax::Get().GetBinaryOperatorInfo(Atom::Concat)->left_priority, 9);
+}
+
+TEST(Lexer, Reset)
+{
+    auto lexer = LuaLexer(std::make_shared<Code>("local a = 'unterminated", "first"));
+    auto buffer = lexer.GetTokenBuffer();
+    auto capacity = buffer.kinds.capacity();
+
+    EXPECT_EQ(buffer.diagnostics.size(), 1);
+
+    // the same lexer and buffer produce what a fresh lexer would for the next file
+    auto code = std::make_shared<Code>("a = 1 -- comment\nb = 0x10", "second");
+    lexer.Reset(code);
+    lexer.GetTokenBuffer(buffer);
+
+    ExpectSameTokenBuffer(buffer, LuaLexer(code).GetTokenBuffer());
+    EXPECT_EQ(buffer.code, code);
+    EXPECT_GE(buffer.kinds.capacity(), capacity);
 }
 
 TEST(Lexer, TypesystemSymbols)
@@ -130,6 +627,18 @@ TEST(Lexer, TypesystemSymbols)
     EXPECT_EQ(Tokenize("$'foo'").size(), 3);
 }
 
+TEST(Lexer, LongestSymbol)
+{
+    auto tokens = Tokenize("a...b..c.d<=e<|f|>");
+
+    EXPECT_EQ(tokens[1]->value, "...");
+    EXPECT_EQ(tokens[3]->value, "..");
+    EXPECT_EQ(tokens[5]->value, ".");
+    EXPECT_EQ(tokens[7]->value, "<=");
+    EXPECT_EQ(tokens[9]->value, "<|");
+    EXPECT_EQ(tokens[11]->value, "|>");
+}
+
 TEST(Lexer, UnknownSymbols)
 {
     EXPECT_EQ(Tokenize("```").size(), 4);
@@ -1,14 +1,14 @@
 #include <assert.h>
 #include <gtest/gtest.h>
 #include "./Helpers.hpp"
-#include "../src/parser/PrimaryExpression.hpp"
+#include "../src/parser/Statement.hpp"
 
 TEST(Parser, EmptyTable)
 {
     auto table = cast_uptr<ParserNode, Table>(Parse("{}"));
 
-    EXPECT_EQ(table->tk_left_bracket->value, "{");
-    EXPECT_EQ(table->tk_right_bracket->value, "}");
+    EXPECT_EQ(table.GetToken(table->tk_left_bracket).value, "{");
+    EXPECT_EQ(table.GetToken(table->tk_right_bracket).value, "}");
 }
 
 TEST(Parser, TableWithIndexValues)
@@ -18,14 +18,14 @@ TEST(Parser, TableWithIndexValues)
     EXPECT_EQ(table->children.size(), 3);
     EXPECT_EQ(table->tk_separators.size(), 2);
 
-    EXPECT_EQ(table->tk_separators[0]->value, ",");
-    EXPECT_EQ(table->tk_separators[1]->value, ",");
+    EXPECT_EQ(table.GetToken(table->tk_separators[0]).value, ",");
+    EXPECT_EQ(table.GetToken(table->tk_separators[1]).value, ",");
 
     for (int i = 0; i < 3; i++)
     {
-        auto child = cast<Table::IndexValue>(table->children[i].get());
-        auto value = cast<Atomic>(child->val.get());
-        EXPECT_EQ(value->value->value, std::to_string(i + 1));
+        auto child = cast<Table::IndexValue>(table->children[i]);
+        auto value = cast<Atomic>(child->val);
+        EXPECT_EQ(table.GetToken(value->value).value, std::to_string(i + 1));
     }
 }
 
@@ -36,58 +36,283 @@ TEST(Parser, TableWithIndexExpressions)
     EXPECT_EQ(table->children.size(), 3);
     EXPECT_EQ(table->tk_separators.size(), 2);
 
-    EXPECT_EQ(table->tk_separators[0]->value, ",");
-    EXPECT_EQ(table->tk_separators[1]->value, ",");
+    EXPECT_EQ(table.GetToken(table->tk_separators[0]).value, ",");
+    EXPECT_EQ(table.GetToken(table->tk_separators[1]).value, ",");
+
+    auto first = cast<Table::ExpressionKeyValue>(table->children[0]);
+
+    EXPECT_EQ(table.GetToken(first->tk_left_bracket).value, "[");
+    EXPECT_EQ(table.GetToken(cast<Atomic>(first->key)->value).value, "1337");
+    EXPECT_EQ(table.GetToken(first->tk_right_bracket).value, "]");
+    EXPECT_EQ(table.GetToken(first->tk_equal).value, "=");
+    EXPECT_EQ(table.GetToken(cast<Atomic>(first->val)->value).value, "1");
+
+    auto second = cast<Table::ExpressionKeyValue>(table->children[1]);
+    EXPECT_EQ(table.GetToken(second->tk_left_bracket).value, "[");
+    EXPECT_EQ(table.GetToken(cast<Atomic>(second->key)->value).value, "\"foo\"");
+    EXPECT_EQ(table.GetToken(second->tk_right_bracket).value, "]");
+    EXPECT_EQ(table.GetToken(second->tk_equal).value, "=");
+    EXPECT_EQ(table.GetToken(cast<Atomic>(second->val)->value).value, "2");
+
+    auto third = cast<Table::ExpressionKeyValue>(table->children[2]);
+    EXPECT_EQ(table.GetToken(third->tk_left_bracket).value, "[");
+    EXPECT_EQ(table.GetToken(cast<Atomic>(third->key)->value).value, "foo");
+    EXPECT_EQ(table.GetToken(third->tk_right_bracket).value, "]");
+    EXPECT_EQ(table.GetToken(third->tk_equal).value, "=");
+    EXPECT_EQ(table.GetToken(cast<Atomic>(third->val)->value).value, "3");
+}
 
-    auto first = cast<Table::ExpressionKeyValue>(table->children[0].get());
+TEST(Parser, BinaryOperator)
+{
+    auto binary = cast_uptr<ParserNode, BinaryOperator>(Parse("1 + 2"));
 
-    EXPECT_EQ(first->tk_left_bracket->value, "[");
-    EXPECT_EQ(cast<Atomic>(first->key.get())->value->value, "1337");
-    EXPECT_EQ(first->tk_right_bracket->value, "]");
-    EXPECT_EQ(first->tk_equal->value, "=");
-    EXPECT_EQ(cast<Atomic>(first->val.get())->value->value, "1");
+    auto left = cast<Atomic>(binary->left);
+    auto right = cast<Atomic>(binary->right);
 
-    auto second = cast<Table::ExpressionKeyValue>(table->children[1].get());
-    EXPECT_EQ(second->tk_left_bracket->value, "[");
-    EXPECT_EQ(cast<Atomic>(second->key.get())->value->value, "\"foo\"");
-    EXPECT_EQ(second->tk_right_bracket->value, "]");
-    EXPECT_EQ(second->tk_equal->value, "=");
-    EXPECT_EQ(cast<Atomic>(second->val.get())->value->value, "2");
+    EXPECT_EQ(binary.GetToken(left->value).value, "1");
+    EXPECT_EQ(binary.GetToken(binary->op).value, "+");
+    EXPECT_EQ(binary.GetToken(right->value).value, "2");
+}
 
-    auto third = cast<Table::ExpressionKeyValue>(table->children[2].get());
-    EXPECT_EQ(third->tk_left_bracket->value, "[");
-    EXPECT_EQ(cast<Atomic>(third->key.get())->value->value, "foo");
-    EXPECT_EQ(third->tk_right_bracket->value, "]");
-    EXPECT_EQ(third->tk_equal->value, "=");
-    EXPECT_EQ(cast<Atomic>(third->val.get())->value->value, "3");
+TEST(Parser, OperatorAssociativity)
+{
+    // left associative: (1 - 2) - 3
+    auto minus = cast_uptr<ParserNode, BinaryOperator>(Parse("1 - 2 - 3"));
+    EXPECT_EQ(minus.GetToken(cast<BinaryOperator>(minus->left)->op).value, "-");
+    EXPECT_EQ(minus.GetToken(cast<Atomic>(minus->right)->value).value, "3");
+
+    // right associative: 2 ^ (3 ^ 4) and 'a' .. ('b' .. 'c')
+    auto power = cast_uptr<ParserNode, BinaryOperator>(Parse("2 ^ 3 ^ 4"));
+    EXPECT_EQ(power.GetToken(cast<Atomic>(power->left)->value).value, "2");
+    EXPECT_EQ(power.GetToken(cast<BinaryOperator>(power->right)->op).value, "^");
+
+    auto concat = cast_uptr<ParserNode, BinaryOperator>(Parse("'a' .. 'b' .. 'c'"));
+    EXPECT_EQ(concat.GetToken(cast<BinaryOperator>(concat->right)->op).value, "..");
+
+    // 1 + (2 * 3) and (1 * 2) + 3
+    auto sum = cast_uptr<ParserNode, BinaryOperator>(Parse("1 + 2 * 3"));
+    EXPECT_EQ(sum.GetToken(sum->op).value, "+");
+    EXPECT_EQ(sum.GetToken(cast<BinaryOperator>(sum->right)->op).value, "*");
+
+    auto product = cast_uptr<ParserNode, BinaryOperator>(Parse("1 * 2 + 3"));
+    EXPECT_EQ(product.GetToken(product->op).value, "+");
+    EXPECT_EQ(product.GetToken(cast<BinaryOperator>(product->left)->op).value, "*");
+
+    auto info = RuntimeSyntax::Get().GetBinaryOperatorInfo(Atom::Caret);
+    EXPECT_TRUE(info->right_associative);
+    EXPECT_FALSE(RuntimeSyntax::Get().GetBinaryOperatorInfo(Atom::Plus)->right_associative);
+    EXPECT_EQ(RuntimeSyntax::Get().GetBinaryOperatorInfo(Atom::Local), nullptr);
 }
 
-TEST(Parser, BinaryOperator)
+TEST(Parser, TypesystemOperators)
 {
-    auto binary = cast_uptr<ParserNode, BinaryOperator>(Parse("1 + 2"));
+    // extends is only a binary operator in the typesystem, which the expression after as is parsed in
+    auto type_cast = cast_uptr<ParserNode, ValueExpression::TypeCast>(Parse("a as b extends c"));
+    auto binary = cast<BinaryOperator>(type_cast->expression);
+
+    EXPECT_EQ(type_cast.GetToken(binary->op).value, "extends");
+    EXPECT_EQ(binary->environment, ParserNode::Typesystem);
+    EXPECT_EQ(type_cast->environment, ParserNode::Runtime);
+
+    EXPECT_EQ(RuntimeSyntax::Get().GetBinaryOperatorInfo(Atom::Extends), nullptr);
+    EXPECT_NE(TypesystemSyntax::Get().GetBinaryOperatorInfo(Atom::Extends), nullptr);
 
-    auto left = cast<Atomic>(binary->left.get());
-    auto right = cast<Atomic>(binary->right.get());
+    // each environment has its own priorities
+    EXPECT_EQ(RuntimeSyntax::Get().GetBinaryOperatorInfo(Atom::Pipe)->left_priority, 4);
+    EXPECT_EQ(TypesystemSyntax::Get().GetBinaryOperatorInfo(Atom::Pipe)->left_priority, 7);
 
-    EXPECT_EQ(left->value->value, "1");
-    EXPECT_EQ(binary->op->value, "+");
-    EXPECT_EQ(right->value->value, "2");
+    EXPECT_EQ(RuntimeSyntax::Get().GetBinaryOperatorInfo(Atom::Tilde)->translation, (std::vector<std::string>{" bit.bxor(", ", ", " )"}));
+    EXPECT_EQ(RuntimeSyntax::Get().GetPrefixOperatorInfo(Atom::Tilde)->translation, (std::vector<std::string>{" bit.bnot(", ")"}));
+    EXPECT_EQ(RuntimeSyntax::Get().GetPostfixOperatorInfo(Atom::Increment)->translation, (std::vector<std::string>{"A = ", "  + 1"}));
+}
+
+TEST(Parser, PullsTokensFromLexer)
+{
+    auto code = std::make_shared<Code>("foo(1, 2) local a = 1 + 2 + 3 + 4 + 5", "test");
+    auto lexer = std::make_shared<LuaLexer>(code);
+    auto parser = LuaParser(lexer);
+    auto call = cast<ValueExpression::Call>(ValueExpression::Parse(parser));
+
+    EXPECT_EQ(call->arguments.size(), 2);
+    EXPECT_EQ(parser.PeekToken()->value, "local");
+    EXPECT_LT(lexer->position, code->GetByteSize());
+}
+
+TEST(Parser, NodeArena)
+{
+    auto table = ParseResult<Table>();
+
+    {
+        auto parser = LuaParser(Tokenize("{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}"));
+        table = parser.Result(cast<Table>(ValueExpression::Parse(parser)));
+    }
+
+    // the nodes and tokens outlive the parser
+    ASSERT_EQ(table->children.size(), 10);
+    EXPECT_EQ(table->tk_separators.size(), 9);
+    EXPECT_EQ(table.GetToken(cast<Atomic>(cast<Table::IndexValue>(table->children[9])->val)->value).value, "10");
+    // 21 tokens up to the closing brace and the end of file
+    EXPECT_EQ(table.GetTokens().Size(), 22);
+    EXPECT_GT(table.GetStorage()->arena.GetSize(), 10 * sizeof(Atomic));
+
+    auto arena = NodeArena();
+    auto list = NodeList<uint64_t>();
+
+    for (uint64_t i = 0; i < 1000; i++)
+        list.push_back(arena, i);
+
+    EXPECT_EQ(list.size(), 1000);
+    EXPECT_EQ(list[999], 999);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&list[0]) % alignof(uint64_t), 0);
+
+    // requests larger than a block get their own
+    auto large = static_cast<char *>(arena.Allocate(1 << 20, 16));
+    large[(1 << 20) - 1] = 1;
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % 16, 0);
+
+    // reset keeps the regular blocks and hands them out again
+    auto reused = NodeArena();
+    auto first = reused.Allocate(8, 8);
+    reused.Allocate(1 << 20, 16);
+    reused.Reset();
+
+    EXPECT_EQ(reused.GetSize(), 0);
+    EXPECT_LT(reused.GetCapacity(), 1 << 20);
+    EXPECT_EQ(reused.Allocate(8, 8), first);
+}
+
+TEST(Parser, TokenStore)
+{
+    EXPECT_EQ(sizeof(TokenRef), 4);
+
+    auto call = cast_uptr<ParserNode, ValueExpression::Call>(Parse("foo(1, 2)"));
+    auto &tokens = call.GetTokens();
+
+    // the store keeps every token in order after parsing, nodes only index into it
+    ASSERT_EQ(tokens.Size(), 7);
+    EXPECT_EQ(tokens.Get(0).value, "foo");
+    EXPECT_EQ(tokens.Back().kind, Token::Kind::EndOfFile);
+    EXPECT_EQ(call->tk_arguments_left.index, 1);
+    EXPECT_EQ(&call.GetToken(call->tk_comma[0]), &tokens.Get(3));
+    EXPECT_FALSE(call->tk_type_call);
+}
+
+TEST(Parser, NodeSideTables)
+{
+    // id, kind and environment, everything optional is kept in the storage
+    EXPECT_EQ(sizeof(Expression), 8);
+    EXPECT_EQ(sizeof(Atomic), 16);
+
+    auto binary = cast_uptr<ParserNode, BinaryOperator>(Parse("a + ((b))"));
+    auto &storage = *binary.GetStorage();
+
+    EXPECT_EQ(storage.node_count, 3);
+    EXPECT_NE(binary->left->id, binary->right->id);
+    EXPECT_EQ(storage.parentheses.size(), 1);
+    EXPECT_EQ(storage.GetParentheses(binary->right)->left.size(), 2);
+    EXPECT_EQ(storage.GetParent(binary->left), binary.get());
+    EXPECT_FALSE(storage.GetTypeColonAssignment(binary.get()));
+}
+
+TEST(Parser, Reset)
+{
+    auto parser = std::make_shared<LuaParser>();
+
+    parser->Reset(TokenizeBuffer("{1, 2, 3}"));
+    auto first = parser->Result(cast<Table>(ValueExpression::Parse(*parser)));
+    auto first_storage = first.GetStorage().get();
+
+    // the first result is still held, so the second file gets new storage
+    parser->Reset(TokenizeBuffer("(a)"));
+    auto second = parser->Result(cast<Atomic>(ValueExpression::Parse(*parser)));
+
+    EXPECT_NE(second.GetStorage().get(), first_storage);
+    EXPECT_EQ(first->children.size(), 3);
+    EXPECT_EQ(first.GetTokens().Size(), 8);
+    EXPECT_EQ(second.GetToken(second->value).value, "a");
+    EXPECT_NE(second.GetStorage()->GetParentheses(second.get()), nullptr);
+
+    // once dropped its storage is emptied and reused for the next file
+    auto second_storage = second.GetStorage().get();
+    auto capacity = second_storage->arena.GetCapacity();
+    second = {};
+
+    parser->Reset(TokenizeBuffer("b + c"));
+    auto third = parser->Result(cast<BinaryOperator>(ValueExpression::Parse(*parser)));
+
+    EXPECT_EQ(third.GetStorage().get(), second_storage);
+    EXPECT_EQ(third.GetStorage()->arena.GetCapacity(), capacity);
+    EXPECT_EQ(third.GetStorage()->node_count, 3);
+    EXPECT_EQ(third.GetStorage()->parentheses.size(), 0);
+    EXPECT_EQ(third.GetTokens().Size(), 4);
+    EXPECT_EQ(third.GetToken(third->op).value, "+");
+}
+
+TEST(Parser, NodeKinds)
+{
+    auto prefix = cast_uptr<ParserNode, PrefixOperator>(Parse("-foo{1, a = 2}"));
+    auto call = cast<ValueExpression::Call>(prefix->right);
+
+    EXPECT_EQ(call->kind, ParserNode::Kind::Call);
+    EXPECT_NE(NodeCast<ValueExpression::PostfixExpression>(call), nullptr);
+    EXPECT_EQ(NodeCast<ValueExpression>(call), nullptr);
+    EXPECT_NE(NodeCast<Expression>(call), nullptr);
+
+    auto table = cast<Table>(call->arguments[0]);
+    EXPECT_NE(NodeCast<Table::Child>(table->children[0]), nullptr);
+    EXPECT_EQ(NodeCast<Table::IdentifierKeyValue>(table->children[0]), nullptr);
+    EXPECT_NE(NodeCast<Table::IdentifierKeyValue>(table->children[1]), nullptr);
+
+    auto describe = [&](auto *node) -> std::string
+    {
+        using T = std::remove_pointer_t<decltype(node)>;
+
+        if constexpr (std::is_same_v<T, Atomic>)
+            return "atomic " + std::string(prefix.GetToken(node->value).value);
+        else if constexpr (std::is_same_v<T, PrefixOperator>)
+            return "prefix " + std::string(prefix.GetToken(node->op).value);
+        else if constexpr (std::is_same_v<T, Table>)
+            return "table of " + std::to_string(node->children.size());
+        else
+            return "other";
+    };
+
+    EXPECT_EQ(VisitNode(prefix.get(), describe), "prefix -");
+    EXPECT_EQ(VisitNode(call, describe), "other");
+    EXPECT_EQ(VisitNode(call->left, describe), "atomic foo");
+    EXPECT_EQ(VisitNode(call->arguments[0], describe), "table of 2");
+}
+
+TEST(Parser, PeekPastEndOfFile)
+{
+    auto parser = std::make_shared<LuaParser>(TokenizeBuffer("a"));
+
+    EXPECT_EQ(parser->PeekToken(0)->value, "a");
+    EXPECT_EQ(parser->PeekToken(3)->kind, Token::Kind::EndOfFile);
+    EXPECT_EQ(parser->GetToken(parser->ReadToken()).value, "a");
+
+    // reading past the end keeps returning the same EndOfFile token
+    auto end_of_file = parser->ReadToken();
+    EXPECT_EQ(parser->GetToken(end_of_file).kind, Token::Kind::EndOfFile);
+    EXPECT_EQ(parser->ReadToken(), end_of_file);
 }
 
 TEST(Parser, Parenthesis)
 {
     auto binary = cast_uptr<ParserNode, BinaryOperator>(Parse("1 + (5*2)"));
 
-    auto left = cast<Atomic>(binary->left.get());
-    auto right = cast<BinaryOperator>(binary->right.get());
-
-    EXPECT_EQ(left->value->value, "1");
-    EXPECT_EQ(binary->op->value, "+");
-    EXPECT_EQ(right->tk_left_parenthesis[0]->value, "(");
-    EXPECT_EQ(cast<Atomic>(right->left.get())->value->value, "5");
-    EXPECT_EQ(right->op->value, "*");
-    EXPECT_EQ(cast<Atomic>(right->right.get())->value->value, "2");
-    EXPECT_EQ(right->tk_right_parenthesis[0]->value, ")");
+    auto left = cast<Atomic>(binary->left);
+    auto right = cast<BinaryOperator>(binary->right);
+
+    EXPECT_EQ(binary.GetToken(left->value).value, "1");
+    EXPECT_EQ(binary.GetToken(binary->op).value, "+");
+    auto parentheses = binary.GetStorage()->GetParentheses(right);
+    EXPECT_EQ(binary.GetStorage()->GetParentheses(left), nullptr);
+    EXPECT_EQ(binary.GetToken(parentheses->left[0]).value, "(");
+    EXPECT_EQ(binary.GetToken(cast<Atomic>(right->left)->value).value, "5");
+    EXPECT_EQ(binary.GetToken(right->op).value, "*");
+    EXPECT_EQ(binary.GetToken(cast<Atomic>(right->right)->value).value, "2");
+    EXPECT_EQ(binary.GetToken(parentheses->right[0]).value, ")");
 }
 
 TEST(Parser, Call)
@@ -97,25 +322,25 @@ TEST(Parser, Call)
     EXPECT_EQ(call->arguments.size(), 3);
     EXPECT_EQ(call->tk_comma.size(), 2);
 
-    EXPECT_EQ(call->tk_comma[0]->value, ",");
-    EXPECT_EQ(call->tk_comma[1]->value, ",");
+    EXPECT_EQ(call.GetToken(call->tk_comma[0]).value, ",");
+    EXPECT_EQ(call.GetToken(call->tk_comma[1]).value, ",");
 
     for (int i = 0; i < 3; i++)
     {
-        auto value = cast<Atomic>(call->arguments[i].get());
-        EXPECT_EQ(value->value->value, std::to_string(i + 1));
+        auto value = cast<Atomic>(call->arguments[i]);
+        EXPECT_EQ(call.GetToken(value->value).value, std::to_string(i + 1));
     }
 }
 TEST(Parser, ChainedCalls)
 {
     auto call_3 = cast_uptr<ParserNode, ValueExpression::Call>(Parse("foo(1)(2)(3)"));
 
-    auto call_2 = cast<ValueExpression::Call>(call_3->left.get());
-    auto call_1 = cast<ValueExpression::Call>(call_2->left.get());
+    auto call_2 = cast<ValueExpression::Call>(call_3->left);
+    auto call_1 = cast<ValueExpression::Call>(call_2->left);
 
-    EXPECT_EQ(cast<Atomic>(call_3->arguments[0].get())->value->value, "3");
-    EXPECT_EQ(cast<Atomic>(call_2->arguments[0].get())->value->value, "2");
-    EXPECT_EQ(cast<Atomic>(call_1->arguments[0].get())->value->value, "1");
+    EXPECT_EQ(call_3.GetToken(cast<Atomic>(call_3->arguments[0])->value).value, "3");
+    EXPECT_EQ(call_3.GetToken(cast<Atomic>(call_2->arguments[0])->value).value, "2");
+    EXPECT_EQ(call_3.GetToken(cast<Atomic>(call_1->arguments[0])->value).value, "1");
 }
 
 TEST(Parser, CallParenthesis)
@@ -124,25 +349,26 @@ TEST(Parser, CallParenthesis)
 
     EXPECT_EQ(call->arguments.size(), 1);
     EXPECT_EQ(call->tk_comma.size(), 0);
-    EXPECT_EQ(cast<Atomic>(call->arguments[0].get())->value->value, "1");
+    EXPECT_EQ(call.GetToken(cast<Atomic>(call->arguments[0])->value).value, "1");
 
-    EXPECT_EQ(call->tk_left_parenthesis[0]->value, "(");
-    EXPECT_EQ(call->tk_right_parenthesis[0]->value, ")");
+    auto parentheses = call.GetStorage()->GetParentheses(call.get());
+    EXPECT_EQ(call.GetToken(parentheses->left[0]).value, "(");
+    EXPECT_EQ(call.GetToken(parentheses->right[0]).value, ")");
 
-    EXPECT_EQ(call->tk_left_parenthesis[1]->value, "(");
-    EXPECT_EQ(call->tk_right_parenthesis[1]->value, ")");
+    EXPECT_EQ(call.GetToken(parentheses->left[1]).value, "(");
+    EXPECT_EQ(call.GetToken(parentheses->right[1]).value, ")");
 }
 
 TEST(Parser, SelfCall)
 {
     auto call = cast_uptr<ParserNode, ValueExpression::Call>(Parse("self:print(1, 2, 3)"));
 
-    auto self = cast<ValueExpression::SelfCall>(call->left.get());
+    auto self = cast<ValueExpression::SelfCall>(call->left);
 
-    EXPECT_EQ(self->op->value, ":");
+    EXPECT_EQ(call.GetToken(self->op).value, ":");
 
-    EXPECT_EQ(cast<Atomic>(self->left.get())->value->value, "self");
-    EXPECT_EQ(cast<Atomic>(self->right.get())->value->value, "print");
+    EXPECT_EQ(call.GetToken(cast<Atomic>(self->left)->value).value, "self");
+    EXPECT_EQ(call.GetToken(cast<Atomic>(self->right)->value).value, "print");
 
     EXPECT_EQ(call->arguments.size(), 3);
 }
@@ -151,39 +377,405 @@ TEST(Parser, IndexExpression)
 {
     auto index = cast_uptr<ParserNode, ValueExpression::IndexExpression>(Parse("a[1]"));
 
-    EXPECT_EQ(index->tk_left_bracket->value, "[");
-    EXPECT_EQ(index->tk_right_bracket->value, "]");
-    EXPECT_EQ(cast<Atomic>(index->index.get())->value->value, "1");
+    EXPECT_EQ(index.GetToken(index->tk_left_bracket).value, "[");
+    EXPECT_EQ(index.GetToken(index->tk_right_bracket).value, "]");
+    EXPECT_EQ(index.GetToken(cast<Atomic>(index->index)->value).value, "1");
 }
 
 TEST(Parser, TypeCast)
 {
     auto type_cast = cast_uptr<ParserNode, ValueExpression::TypeCast>(Parse("\"foo\" as foo"));
 
-    EXPECT_EQ(type_cast->tk_operator->value, "as");
+    EXPECT_EQ(type_cast.GetToken(type_cast->tk_operator).value, "as");
 
-    EXPECT_EQ(cast<Atomic>(type_cast->left.get())->value->value, "\"foo\"");
-    EXPECT_EQ(cast<Atomic>(type_cast->expression.get())->value->value, "foo");
+    EXPECT_EQ(type_cast.GetToken(cast<Atomic>(type_cast->left)->value).value, "\"foo\"");
+    EXPECT_EQ(type_cast.GetToken(cast<Atomic>(type_cast->expression)->value).value, "foo");
 }
 
 TEST(Parser, PrefixOperator)
 {
     auto prefix = cast_uptr<ParserNode, PrefixOperator>(Parse("-1"));
 
-    EXPECT_EQ(prefix->op->value, "-");
-    EXPECT_EQ(cast<Atomic>(prefix->right.get())->value->value, "1");
+    EXPECT_EQ(prefix.GetToken(prefix->op).value, "-");
+    EXPECT_EQ(prefix.GetToken(cast<Atomic>(prefix->right)->value).value, "1");
+}
+
+TEST(Parser, PrefixOperatorPriority)
+{
+    // -(2 ^ 3), the power binds tighter than the minus
+    auto power = cast_uptr<ParserNode, PrefixOperator>(Parse("-2 ^ 3"));
+    EXPECT_EQ(power.GetToken(cast<BinaryOperator>(power->right)->op).value, "^");
+
+    // (-a) + b and (not a) == b
+    auto sum = cast_uptr<ParserNode, BinaryOperator>(Parse("-a + b"));
+    EXPECT_EQ(sum.GetToken(cast<PrefixOperator>(sum->left)->op).value, "-");
+
+    auto equal = cast_uptr<ParserNode, BinaryOperator>(Parse("not a == b"));
+    EXPECT_EQ(equal.GetToken(cast<PrefixOperator>(equal->left)->op).value, "not");
+}
+
+TEST(Parser, CallArgumentExpressions)
+{
+    auto call = cast_uptr<ParserNode, ValueExpression::Call>(Parse("f(a + 1, {b = 2; 3}, -c)"));
+
+    ASSERT_EQ(call->arguments.size(), 3);
+    EXPECT_EQ(call.GetToken(cast<BinaryOperator>(call->arguments[0])->op).value, "+");
+    EXPECT_EQ(cast<Table>(call->arguments[1])->children.size(), 2);
+    EXPECT_EQ(call.GetToken(cast<PrefixOperator>(call->arguments[2])->op).value, "-");
+    EXPECT_EQ(call.GetToken(call->tk_arguments_right).value, ")");
+}
+
+TEST(Parser, TableCallArguments)
+{
+    auto binary = cast_uptr<ParserNode, BinaryOperator>(Parse("f{1} + 2"));
+    auto call = cast<ValueExpression::Call>(binary->left);
+    ASSERT_EQ(call->arguments.size(), 1);
+    EXPECT_EQ(cast<Table>(call->arguments[0])->children.size(), 1);
+
+    auto index = cast_uptr<ParserNode, ValueExpression::Index>(Parse("f{1}.x"));
+    cast<ValueExpression::Call>(index->left);
+
+    auto method = cast_uptr<ParserNode, ValueExpression::Call>(Parse("f{1}:m()"));
+    auto self = cast<ValueExpression::SelfCall>(method->left);
+    cast<ValueExpression::Call>(self->left);
+
+    auto outer = cast_uptr<ParserNode, ValueExpression::Call>(Parse("f{1}{2}"));
+    ASSERT_EQ(outer->arguments.size(), 1);
+    EXPECT_EQ(cast<Table>(outer->arguments[0])->children.size(), 1);
+    auto inner = cast<ValueExpression::Call>(outer->left);
+    ASSERT_EQ(inner->arguments.size(), 1);
+    cast<Table>(inner->arguments[0]);
+}
+
+TEST(Parser, DeepNesting)
+{
+    // every level takes three frames, the table, its child and the parentheses
+    std::string code;
+    for (int i = 0; i < 3000; i++)
+        code += "{(";
+    code += "1";
+    for (int i = 0; i < 3000; i++)
+        code += ")}";
+
+    auto table = cast_uptr<ParserNode, Table>(Parse(code));
+    EXPECT_EQ(table->children.size(), 1);
+
+    std::string concat = "a";
+    for (int i = 0; i < 9000; i++)
+        concat += " .. a";
+
+    // right associative, so every operator is on the right of the one before it
+    auto binary = cast_uptr<ParserNode, BinaryOperator>(Parse(concat));
+    size_t depth = 1;
+    for (auto node = binary.get(); NodeCast<BinaryOperator>(node->right); node = static_cast<BinaryOperator *>(node->right))
+        depth++;
+    EXPECT_EQ(depth, 9000);
+}
+
+TEST(Parser, NestingLimit)
+{
+    LuaParser parser(TokenizeBuffer("((((1))))"));
+    parser.max_expression_depth = 4;
+    auto result = parser.ParseExpression();
+    ASSERT_FALSE(result.GetDiagnostics().empty());
+    EXPECT_EQ(result.GetDiagnostics()[0].code, ParserDiagnostic::ExpressionTooDeep);
+    EXPECT_TRUE(parser.expression_stack.empty());
+
+    // the root frame and the three parentheses around 1 fit
+    parser.Reset(TokenizeBuffer("(((1)))"));
+    result = parser.ParseExpression();
+    EXPECT_NE(result.get(), nullptr);
+    EXPECT_TRUE(result.GetDiagnostics().empty());
 }
 
 TEST(Parser, Function)
 {
     auto node = cast_uptr<ParserNode, Function>(Parse("function(a,b,c) end"));
 
-    EXPECT_EQ(node->tk_function->value, "function");
-    EXPECT_EQ(node->tk_arguments_left->value, "(");
+    EXPECT_EQ(node.GetToken(node->tk_function).value, "function");
+    EXPECT_EQ(node.GetToken(node->tk_arguments_left).value, "(");
     EXPECT_EQ(node->arguments.size(), 3);
-    EXPECT_EQ(cast<Atomic>(node->arguments[0].get())->value->value, "a");
-    EXPECT_EQ(cast<Atomic>(node->arguments[1].get())->value->value, "b");
-    EXPECT_EQ(cast<Atomic>(node->arguments[2].get())->value->value, "c");
-    EXPECT_EQ(node->tk_arguments_right->value, ")");
-    EXPECT_EQ(node->tk_end->value, "end");
-}
\ No newline at end of file
+    EXPECT_EQ(node.GetToken(cast<Atomic>(node->arguments[0])->value).value, "a");
+    EXPECT_EQ(node.GetToken(cast<Atomic>(node->arguments[1])->value).value, "b");
+    EXPECT_EQ(node.GetToken(cast<Atomic>(node->arguments[2])->value).value, "c");
+    EXPECT_EQ(node.GetToken(node->tk_arguments_right).value, ")");
+    EXPECT_EQ(node.GetToken(node->tk_end).value, "end");
+}
+
+TEST(Parser, Statements)
+{
+    auto root = ParseFile(R"(
+        local a, b = 1, 2
+        a.b, c[1] = 3, 4
+        print(a)
+        i++
+        if a then elseif b then else end
+        for i = 1, 10, 2 do end
+        for k, v in pairs(t) do break end
+        while a do continue end
+        repeat local x until x
+        do goto done end
+        ::done::;
+        function a.b:c(x, ...) return x end
+        local function f() end
+        return a, b
+    )");
+
+    std::vector<ParserNode::Kind> kinds;
+    for (auto statement : root->statements)
+        kinds.push_back(statement->kind);
+
+    using Kind = ParserNode::Kind;
+    EXPECT_EQ(kinds, (std::vector<Kind>{
+                         Kind::LocalAssignmentStatement,
+                         Kind::AssignmentStatement,
+                         Kind::ExpressionStatement,
+                         Kind::ExpressionStatement,
+                         Kind::IfStatement,
+                         Kind::NumericForStatement,
+                         Kind::GenericForStatement,
+                         Kind::WhileStatement,
+                         Kind::RepeatStatement,
+                         Kind::DoStatement,
+                         Kind::GotoLabelStatement,
+                         Kind::SemicolonStatement,
+                         Kind::FunctionStatement,
+                         Kind::LocalFunctionStatement,
+                         Kind::ReturnStatement,
+                         Kind::EndOfFileStatement,
+                     }));
+
+    auto assignment = cast<AssignmentStatement>(root->statements[1]);
+    EXPECT_EQ(assignment->left.size(), 2);
+    EXPECT_EQ(assignment->right.size(), 2);
+    cast<ValueExpression::IndexExpression>(assignment->left[1]);
+
+    auto branches = cast<IfStatement>(root->statements[4]);
+    EXPECT_EQ(branches->conditions.size(), 2);
+    EXPECT_EQ(branches->blocks.size(), 3);
+    EXPECT_EQ(root.GetToken(branches->tk_if[2]).value, "else");
+
+    auto numeric = cast<NumericForStatement>(root->statements[5]);
+    EXPECT_EQ(root.GetToken(cast<Atomic>(numeric->step)->value).value, "2");
+
+    auto generic = cast<GenericForStatement>(root->statements[6]);
+    EXPECT_EQ(generic->identifiers.size(), 2);
+    cast<BreakStatement>(generic->statements[0]);
+
+    auto repeat = cast<RepeatStatement>(root->statements[8]);
+    cast<LocalAssignmentStatement>(repeat->statements[0]);
+    EXPECT_EQ(root.GetToken(cast<Atomic>(repeat->condition)->value).value, "x");
+
+    cast<GotoStatement>(cast<DoStatement>(root->statements[9])->statements[0]);
+
+    // the name is a.b followed by the self call :c
+    auto method = cast<FunctionStatement>(root->statements[12]);
+    auto self_call = cast<ValueExpression::SelfCall>(method->name);
+    cast<ValueExpression::Index>(self_call->left);
+    EXPECT_EQ(method->function->arguments.size(), 2);
+    cast<ReturnStatement>(method->function->statements[0]);
+
+    EXPECT_EQ(cast<ReturnStatement>(root->statements[14])->expressions.size(), 2);
+}
+
+TEST(Parser, TypeStatements)
+{
+    auto root = ParseFile(R"(
+        --[[# local type Vector = {x = number, y = number} ]]
+        --[[# type Vector.z = number ]]
+        local v --[[#: Vector]] = {x = 1, y = 2}
+        local type function length(v: Vector): number return v.x end
+        local type = 1
+    )");
+
+    auto local_type = cast<LocalAssignmentStatement>(root->statements[0]);
+    EXPECT_EQ(root.GetToken(local_type->tk_type).value, "type");
+    EXPECT_EQ(local_type->environment, ParserNode::Typesystem);
+    EXPECT_EQ(local_type->right[0]->environment, ParserNode::Typesystem);
+
+    auto type = cast<AssignmentStatement>(root->statements[1]);
+    EXPECT_EQ(type->environment, ParserNode::Typesystem);
+    cast<ValueExpression::Index>(type->left[0]);
+
+    // annotations are kept in the side tables of the identifier
+    auto local = cast<LocalAssignmentStatement>(root->statements[2]);
+    EXPECT_EQ(local->environment, ParserNode::Runtime);
+    auto annotation = cast<Atomic>(root.GetStorage()->GetTypeExpression(local->left[0]));
+    EXPECT_EQ(root.GetToken(annotation->value).value, "Vector");
+    EXPECT_EQ(annotation->environment, ParserNode::Typesystem);
+    EXPECT_EQ(root.GetToken(root.GetStorage()->GetTypeColonAssignment(local->left[0])).value, ":");
+
+    auto function = cast<LocalFunctionStatement>(root->statements[3]);
+    EXPECT_EQ(function->environment, ParserNode::Typesystem);
+    EXPECT_NE(root.GetStorage()->GetTypeExpression(function->function->arguments[0]), nullptr);
+    EXPECT_EQ(root.GetToken(cast<Atomic>(function->function->return_types[0])->value).value, "number");
+
+    // type is only a keyword when a name follows
+    auto variable = cast<LocalAssignmentStatement>(root->statements[4]);
+    EXPECT_FALSE(variable->tk_type);
+    EXPECT_EQ(root.GetToken(variable->left[0]->value).value, "type");
+}
+
+TEST(Parser, FunctionBody)
+{
+    auto call = cast_uptr<ParserNode, ValueExpression::Call>(Parse("pcall(function(a) if a then return a + 1 end end, 1)"));
+    auto function = cast<Function>(call->arguments[0]);
+    auto branch = cast<IfStatement>(function->statements[0]);
+    cast<BinaryOperator>(cast<ReturnStatement>(branch->blocks[0][0])->expressions[0]);
+    EXPECT_EQ(call->arguments.size(), 2);
+}
+
+TEST(Parser, StatementErrors)
+{
+    for (auto code : {"x", "1 = 2", "f() = 1", "end", "if a then", "local function() end", "for i = 1 do end", "function f(a,) end"})
+    {
+        auto parser = LuaParser(TokenizeBuffer(code));
+        auto root = parser.ParseFile();
+        EXPECT_FALSE(root.GetDiagnostics().empty()) << code;
+        EXPECT_EQ(root->statements[root->statements.size() - 1]->kind, ParserNode::Kind::EndOfFileStatement) << code;
+    }
+}
+
+TEST(Parser, ErrorRecovery)
+{
+    auto code = std::make_shared<Code>("local a = {1, 2 3, x = }\n"
+                                       "if a then print(a end\n"
+                                       "local b = f(1, , 2)\n"
+                                       "x y = 1\n"
+                                       "end\n"
+                                       "local c = 1",
+                                       "test");
+    auto parser = LuaParser(LuaLexer(code).GetTokenBuffer());
+    auto root = parser.ParseFile();
+    auto &diagnostics = root.GetDiagnostics();
+
+    std::vector<std::string> messages;
+    for (auto &diagnostic : diagnostics)
+        messages.push_back(diagnostic.GetMessage(root.GetTokens()));
+
+    EXPECT_EQ(messages, (std::vector<std::string>{
+                            "expected '}', got '3'",
+                            "expected an expression, got '}'",
+                            "expected ')', got 'end'",
+                            "expected an expression, got ','",
+                            "expected assignment or call expression, got 'x'",
+                            "expected end of file, got 'end'",
+                        }));
+
+    // the tables and calls keep what could be parsed, missing values are error nodes
+    auto table = cast<Table>(cast<LocalAssignmentStatement>(root->statements[0])->right[0]);
+    EXPECT_EQ(table->children.size(), 3);
+    cast<ErrorExpression>(static_cast<Table::IdentifierKeyValue *>(table->children[2])->val);
+    EXPECT_TRUE(table->tk_right_bracket);
+
+    auto branch = cast<IfStatement>(root->statements[1]);
+    EXPECT_EQ(cast<ValueExpression::Call>(cast<ExpressionStatement>(branch->blocks[0][0])->value)->arguments.size(), 1);
+    EXPECT_TRUE(branch->tk_end);
+
+    auto call = cast<ValueExpression::Call>(cast<LocalAssignmentStatement>(root->statements[2])->right[0]);
+    EXPECT_EQ(call->arguments.size(), 3);
+    cast<ErrorExpression>(call->arguments[1]);
+
+    // x on its own is skipped, the assignment after it is not
+    auto error = cast<ErrorStatement>(root->statements[3]);
+    EXPECT_EQ(root.GetToken(cast<Atomic>(error->value)->value).value, "x");
+    cast<AssignmentStatement>(root->statements[4]);
+
+    // the stray end is skipped and the rest of the file is parsed
+    EXPECT_EQ(root.GetToken(cast<ErrorStatement>(root->statements[5])->tk_start).value, "end");
+    cast<LocalAssignmentStatement>(root->statements[6]);
+    cast<EndOfFileStatement>(root->statements[7]);
+}
+
+TEST(Parser, MissingTokens)
+{
+    auto code = std::make_shared<Code>("while a print(a) end", "test");
+    auto parser = LuaParser(LuaLexer(code).GetTokenBuffer());
+    auto root = parser.ParseFile();
+
+    ASSERT_EQ(root.GetDiagnostics().size(), 1);
+    auto &diagnostic = root.GetDiagnostics()[0];
+    EXPECT_EQ(diagnostic.code, ParserDiagnostic::ExpectedToken);
+    EXPECT_EQ(diagnostic.expected, Atom::Do);
+    EXPECT_EQ(root.GetToken(diagnostic.start).value, "print");
+
+    // a missing token is left empty and nothing is skipped for it
+    auto loop = cast<WhileStatement>(root->statements[0]);
+    EXPECT_FALSE(loop->tk_do);
+    EXPECT_EQ(loop->statements.size(), 1);
+    EXPECT_TRUE(loop->tk_end);
+}
+
+TEST(Parser, CascadingErrors)
+{
+    // every construct left open by the missing parenthesis ends at the end of the file, which is reported once
+    auto parser = LuaParser(TokenizeBuffer("if a then local t = {f(function() return ("));
+    auto root = parser.ParseFile();
+    ASSERT_EQ(root.GetDiagnostics().size(), 1);
+    EXPECT_EQ(root.GetDiagnostics()[0].code, ParserDiagnostic::EmptyParentheses);
+}
+
+TEST(Parser, BlockNestingLimit)
+{
+    auto nested = [](size_t depth)
+    {
+        std::string code;
+        for (size_t i = 0; i < depth; i++)
+            code += "do ";
+        for (size_t i = 0; i < depth; i++)
+            code += "end ";
+        return code;
+    };
+
+    auto parser = LuaParser(TokenizeBuffer(nested(500)));
+    EXPECT_EQ(parser.ParseFile()->statements.size(), 2);
+    EXPECT_EQ(parser.block_depth, 0);
+
+    // an error instead of running out of native stack
+    parser.Reset(TokenizeBuffer(nested(20000)));
+    auto root = parser.ParseFile();
+    ASSERT_FALSE(root.GetDiagnostics().empty());
+    EXPECT_EQ(root.GetDiagnostics()[0].code, ParserDiagnostic::BlockTooDeep);
+    EXPECT_EQ(parser.block_depth, 0);
+
+    // function bodies in expressions count as blocks
+    std::string functions;
+    for (size_t i = 0; i < 20000; i++)
+        functions += "return function() ";
+    for (size_t i = 0; i < 20000; i++)
+        functions += "end ";
+
+    parser.Reset(TokenizeBuffer(functions));
+    root = parser.ParseFile();
+    ASSERT_FALSE(root.GetDiagnostics().empty());
+    EXPECT_EQ(root.GetDiagnostics()[0].code, ParserDiagnostic::BlockTooDeep);
+    EXPECT_TRUE(parser.expression_stack.empty());
+}
+
+TEST(Parser, StreamStatements)
+{
+    auto code = "local a = {1, 2, 3} print(a) local b = a[1] return b";
+    auto parser = LuaParser(TokenizeBuffer(code));
+    std::vector<ParserNode::Kind> kinds;
+    std::vector<uint32_t> node_counts;
+    ParseResult<Statement> kept;
+
+    parser.ParseStatements([&](ParseResult<Statement> statement)
+                           {
+                               kinds.push_back(statement->kind);
+                               node_counts.push_back(statement.GetStorage()->node_count);
+
+                               if (statement->kind == ParserNode::Kind::ExpressionStatement)
+                                   kept = statement; });
+
+    using Kind = ParserNode::Kind;
+    EXPECT_EQ(kinds, (std::vector<Kind>{Kind::LocalAssignmentStatement, Kind::ExpressionStatement, Kind::LocalAssignmentStatement, Kind::ReturnStatement, Kind::EndOfFileStatement}));
+
+    // every statement starts with empty storage
+    EXPECT_EQ(node_counts, (std::vector<uint32_t>{9, 4, 5, 2, 1}));
+
+    // a statement the callback kept is not overwritten by the ones after it
+    auto call = cast<ValueExpression::Call>(cast<ExpressionStatement>(kept.get())->value);
+    EXPECT_EQ(kept.GetToken(cast<Atomic>(call->left)->value).value, "print");
+    EXPECT_EQ(kept.GetStorage()->node_count, 4);
+}